@@ -0,0 +1,471 @@
+#include "GpuContext.hpp"
+#include "dda/ChunkedWorld.hpp"
+#include "dda/DistanceField.hpp"
+#include "dda/FixedPoint.hpp"
+#include "dda/GpuCaster.hpp"
+#include "dda/Grid.hpp"
+#include "dda/JobPool.hpp"
+#include "dda/Kernel.hpp"
+#include "dda/RayCaster.hpp"
+#include "dda/Visibility.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	constexpr int cell_size = 32;
+
+	/* splitmix64, so that grids and rays are identical on every platform and standard library. */
+	class Random
+	{
+	private:
+		std::uint64_t state_;
+
+	public:
+		explicit Random(std::uint64_t seed) : state_(seed)
+		{
+		}
+
+		std::uint64_t Next()
+		{
+			std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
+		}
+
+		/* Uniform in [0, 1). */
+		float NextFloat()
+		{
+			return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+		}
+	};
+
+	struct Options
+	{
+		bool quick_;
+		bool gpu_;
+		std::size_t rays_;
+		std::uint64_t seed_;
+		unsigned threads_;
+		double min_seconds_;
+	};
+
+	struct GridSize
+	{
+		int width_;
+		int height_;
+	};
+
+	/* Rays are limited to max_cells_ cells, or run until they hit or leave the grid if it is 0. */
+	struct Scenario
+	{
+		const char* name_;
+		float max_cells_;
+	};
+
+	struct Measurement
+	{
+		double seconds_;
+		std::size_t repetitions_;
+		std::size_t hits_;
+		std::uint64_t checksum_;
+	};
+
+	struct Method
+	{
+		const char* name_;
+		std::function<void()> cast_;
+		std::function<void(std::size_t&, std::uint64_t&)> digest_;
+	};
+
+	void Usage(const char* program)
+	{
+		fprintf(stderr, "Usage: %s [--quick] [--gpu] [--rays N] [--seed N] [--threads N] [--min-seconds S]\n", program);
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options)
+	{
+		options = { false, false, 0, 1, 0, 0.0 };
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const bool has_value = i + 1 < argc;
+
+			if (std::strcmp(argv[i], "--quick") == 0)
+			{
+				options.quick_ = true;
+			}
+			else if (std::strcmp(argv[i], "--gpu") == 0)
+			{
+				options.gpu_ = true;
+			}
+			else if (std::strcmp(argv[i], "--rays") == 0 && has_value)
+			{
+				options.rays_ = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else if (std::strcmp(argv[i], "--seed") == 0 && has_value)
+			{
+				options.seed_ = std::strtoull(argv[++i], nullptr, 10);
+			}
+			else if (std::strcmp(argv[i], "--threads") == 0 && has_value)
+			{
+				options.threads_ = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (std::strcmp(argv[i], "--min-seconds") == 0 && has_value)
+			{
+				options.min_seconds_ = std::strtod(argv[++i], nullptr);
+			}
+			else
+			{
+				Usage(argv[0]);
+				return false;
+			}
+		}
+
+		if (options.rays_ == 0)
+		{
+			options.rays_ = options.quick_ ? 4096 : 16384;
+		}
+
+		if (options.min_seconds_ <= 0.0)
+		{
+			options.min_seconds_ = options.quick_ ? 0.02 : 0.2;
+		}
+
+		return true;
+	}
+
+	dda::Grid MakeGrid(const GridSize& size, int density_percent, Random& random)
+	{
+		dda::Grid grid(size.width_, size.height_, cell_size);
+
+		if (density_percent == 0)
+		{
+			return grid;
+		}
+
+		for (int y = 0; y < size.height_; ++y)
+		{
+			for (int x = 0; x < size.width_; ++x)
+			{
+				if (static_cast<int>(random.Next() % 100) < density_percent)
+				{
+					grid.SetWall(x, y, true);
+				}
+			}
+		}
+
+		grid.ClearDirtyRegion();
+		return grid;
+	}
+
+	void MakeRays(const GridSize& size, std::size_t count, Random& random, std::vector<Vector2d<float>>& origins, std::vector<Vector2d<float>>& directions)
+	{
+		origins.resize(count);
+		directions.resize(count);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			origins[i] = { random.NextFloat() * static_cast<float>(size.width_ * cell_size), random.NextFloat() * static_cast<float>(size.height_ * cell_size) };
+
+			do
+			{
+				directions[i] = { random.NextFloat() * 2.0f - 1.0f, random.NextFloat() * 2.0f - 1.0f };
+			}
+			while (directions[i].x == 0.0f && directions[i].y == 0.0f);
+		}
+	}
+
+	void Digest(const dda::RayHit& hit, std::size_t& hits, std::uint64_t& checksum)
+	{
+		if (hit.hit_)
+		{
+			++hits;
+		}
+
+		checksum = (checksum ^ (static_cast<std::uint64_t>(hit.cell_.x) * 73856093 ^ static_cast<std::uint64_t>(hit.cell_.y) * 19349663)) * 0x100000001b3ull;
+	}
+
+	void Digest(const dda::FixedHit& hit, std::size_t& hits, std::uint64_t& checksum)
+	{
+		Digest(dda::RayHit{ hit.hit_, hit.cell_, { 0.0f, 0.0f }, 0.0f, hit.face_ }, hits, checksum);
+	}
+
+	/* Digests where a polygon's rays stop, to the nearest world unit, and counts its rays as hits. */
+	void Digest(const dda::VisibilityPolygon& polygon, std::size_t& hits, std::uint64_t& checksum)
+	{
+		hits += polygon.points_.size();
+
+		for (const Vector2d<float>& point : polygon.points_)
+		{
+			checksum = (checksum ^ (static_cast<std::uint64_t>(std::lround(point.x)) * 73856093 ^ static_cast<std::uint64_t>(std::lround(point.y)) * 19349663)) * 0x100000001b3ull;
+		}
+	}
+
+	constexpr std::uint64_t checksum_seed = 0xcbf29ce484222325ull;
+
+	/* Best time of repeated runs, repeated until min_seconds have passed in total. */
+	Measurement Measure(const Method& method, double min_seconds)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		Measurement measurement = { 0.0, 0, 0, checksum_seed };
+
+		method.cast_();
+
+		double total = 0.0;
+		double best = 0.0;
+
+		while (measurement.repetitions_ == 0 || total < min_seconds)
+		{
+			const Clock::time_point start = Clock::now();
+			method.cast_();
+			const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+			best = measurement.repetitions_ == 0 ? seconds : std::min(best, seconds);
+			total += seconds;
+			++measurement.repetitions_;
+		}
+
+		measurement.seconds_ = best;
+		method.digest_(measurement.hits_, measurement.checksum_);
+		return measurement;
+	}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	Options options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	const std::vector<GridSize> sizes = options.quick_ ? std::vector<GridSize>{ { 30, 20 }, { 256, 256 }, { 1024, 1024 } } : std::vector<GridSize>{ { 30, 20 }, { 256, 256 }, { 1024, 1024 }, { 4096, 4096 }, { 16384, 16384 } };
+	const std::vector<int> densities = { 0, 1, 10, 50 };
+	const Scenario scenarios[] = { { "short", 4.0f }, { "medium", 64.0f }, { "full", 0.0f } };
+	const dda::Kernel kernels[] = { dda::Kernel::scalar, dda::Kernel::hierarchical, dda::Kernel::distance_field, dda::Kernel::sse2, dda::Kernel::avx2, dda::Kernel::avx512, dda::Kernel::neon };
+
+	dda::JobPool pool(options.threads_);
+
+	// Destroyed before the context its GPU objects live in.
+	std::unique_ptr<dda::GpuCaster> gpu_caster;
+
+	if (options.gpu_)
+	{
+		gpu_caster = std::make_unique<dda::GpuCaster>();
+
+		if (!gpu_caster->Initialize(CreateGpuContext()))
+		{
+			fprintf(stderr, "GPU caster unavailable, benchmarking the CPU only\n");
+			gpu_caster.reset();
+		}
+	}
+
+	printf("{\n");
+	printf("  \"benchmark\": \"dda\",\n");
+	printf("  \"seed\": %llu,\n", static_cast<unsigned long long>(options.seed_));
+	printf("  \"rays\": %zu,\n", options.rays_);
+	printf("  \"cell_size\": %d,\n", cell_size);
+	printf("  \"threads\": %u,\n", pool.GetThreadCount());
+	printf("  \"best_kernel\": \"%s\",\n", dda::GetKernelName(dda::GetBestKernel()));
+	printf("  \"gpu\": \"%s\",\n", gpu_caster != nullptr ? gpu_caster->GetDeviceName() : "");
+	printf("  \"results\": [");
+
+	bool first = true;
+
+	for (const GridSize& size : sizes)
+	{
+		for (const int density : densities)
+		{
+			Random random(options.seed_ ^ (static_cast<std::uint64_t>(size.width_) << 40) ^ (static_cast<std::uint64_t>(size.height_) << 16) ^ static_cast<std::uint64_t>(density));
+			const dda::Grid grid = MakeGrid(size, density, random);
+			const dda::DistanceField distance_field(grid.GetView());
+			const dda::RayCaster ray_caster(distance_field.Attach(grid.GetView()));
+
+			if (gpu_caster != nullptr)
+			{
+				gpu_caster->SetGrid(grid.GetView());
+			}
+
+			/* Same walls streamed in 256x256 chunks, with fewer resident than the large grids need. */
+			const dda::GridView view = grid.GetView();
+			dda::ChunkedWorld chunked_world(size.width_, size.height_, cell_size, 8, 64, [view](int chunk_x, int chunk_y, dda::Grid& chunk) { dda::ChunkedWorld::CopyChunk(view, chunk_x, chunk_y, chunk); });
+
+			std::vector<Vector2d<float>> origins;
+			std::vector<Vector2d<float>> directions;
+			MakeRays(size, options.rays_, random, origins, directions);
+
+			// The fixed-point rays are quantized, so they are checked against
+			// the scalar kernel casting the same quantized rays in floats. On
+			// the largest grids floats cannot hold every quantized origin,
+			// and a long ray can then still round a corner the other way.
+			std::vector<Vector2d<dda::Fixed>> fixed_origins(origins.size());
+			std::vector<Vector2d<dda::Fixed>> fixed_directions(directions.size());
+			std::vector<Vector2d<float>> quantized_origins(origins.size());
+			std::vector<Vector2d<float>> quantized_directions(directions.size());
+
+			for (std::size_t i = 0; i < origins.size(); ++i)
+			{
+				fixed_origins[i] = dda::ToFixed(origins[i]);
+				fixed_directions[i] = { static_cast<dda::Fixed>(directions[i].x * 32768.0f), static_cast<dda::Fixed>(directions[i].y * 32768.0f) };
+				quantized_origins[i] = { dda::FromFixed(fixed_origins[i].x), dda::FromFixed(fixed_origins[i].y) };
+				quantized_directions[i] = { static_cast<float>(fixed_directions[i].x), static_cast<float>(fixed_directions[i].y) };
+			}
+
+			std::vector<dda::RayHit> results(options.rays_);
+			std::vector<dda::FixedHit> fixed_results(options.rays_);
+
+			for (const Scenario& scenario : scenarios)
+			{
+				const float max_distance = scenario.max_cells_ > 0.0f ? scenario.max_cells_ * cell_size : 1e30f;
+				const std::int64_t fixed_max_distance = scenario.max_cells_ > 0.0f ? static_cast<std::int64_t>(scenario.max_cells_) * (cell_size << dda::fixed_shift) : INT64_MAX;
+
+				const auto digest_results = [&](std::size_t& hits, std::uint64_t& checksum)
+				{
+					for (const dda::RayHit& hit : results)
+					{
+						Digest(hit, hits, checksum);
+					}
+				};
+
+				std::vector<Method> methods;
+
+				for (const dda::Kernel kernel : kernels)
+				{
+					if (dda::IsKernelSupported(kernel))
+					{
+						methods.push_back({ dda::GetKernelName(kernel), [&, kernel] { ray_caster.CastBatch(origins, directions, max_distance, results, kernel); }, digest_results });
+					}
+				}
+
+				methods.push_back({ "fixed", [&] { dda::CastFixedBatch(grid.GetView(), fixed_origins, fixed_directions, fixed_max_distance, fixed_results); }, [&](std::size_t& hits, std::uint64_t& checksum)
+				{
+					for (const dda::FixedHit& hit : fixed_results)
+					{
+						Digest(hit, hits, checksum);
+					}
+				} });
+
+				methods.push_back({ "parallel", [&] { ray_caster.CastBatch(pool, origins, directions, max_distance, results); }, digest_results });
+
+				if (gpu_caster != nullptr)
+				{
+					methods.push_back({ "gpu", [&] { gpu_caster->CastBatch(origins, directions, max_distance, results); }, digest_results });
+				}
+
+				methods.push_back({ "chunked", [&]
+				{
+					for (std::size_t i = 0; i < origins.size(); ++i)
+					{
+						results[i] = chunked_world.Cast(origins[i], directions[i], max_distance);
+					}
+				}, digest_results });
+
+				std::uint64_t scalar_checksum = 0;
+				std::size_t quantized_hits = 0;
+				std::uint64_t quantized_checksum = checksum_seed;
+				ray_caster.CastBatch(quantized_origins, quantized_directions, max_distance, results, dda::Kernel::scalar);
+				digest_results(quantized_hits, quantized_checksum);
+
+				for (const Method& method : methods)
+				{
+					fprintf(stderr, "%dx%d density %d%% %s %s\n", size.width_, size.height_, density, scenario.name_, method.name_);
+
+					const Measurement measurement = Measure(method, options.min_seconds_);
+
+					if (std::strcmp(method.name_, "scalar") == 0)
+					{
+						scalar_checksum = measurement.checksum_;
+					}
+
+					const std::uint64_t reference_checksum = std::strcmp(method.name_, "fixed") == 0 ? quantized_checksum : scalar_checksum;
+
+					printf("%s\n    { \"width\": %d, \"height\": %d, \"density\": %d, \"rays\": \"%s\", \"method\": \"%s\", ", first ? "" : ",", size.width_, size.height_, density, scenario.name_, method.name_);
+					printf("\"seconds\": %.9f, \"repetitions\": %zu, \"rays_per_second\": %.0f, ", measurement.seconds_, measurement.repetitions_, static_cast<double>(options.rays_) / measurement.seconds_);
+					printf("\"hits\": %zu, \"checksum\": \"%016llx\", \"matches_scalar\": %s }", measurement.hits_, static_cast<unsigned long long>(measurement.checksum_), measurement.checksum_ == reference_checksum ? "true" : "false");
+					fflush(stdout);
+					first = false;
+				}
+			}
+		}
+	}
+
+	// Full circle corner polygons on a large map, as the demo's corners
+	// mode casts them. Their "hits" are the rays the polygons took, and
+	// their rays per second count those rays.
+	const GridSize corner_size = { 4096, 4096 };
+	constexpr std::size_t corner_origins = 4;
+	constexpr float full_circle = 6.28318530717958647692f;
+
+	for (const int density : densities)
+	{
+		Random random(options.seed_ ^ (static_cast<std::uint64_t>(corner_size.width_) << 40) ^ (static_cast<std::uint64_t>(corner_size.height_) << 16) ^ static_cast<std::uint64_t>(density) ^ 0xc0u);
+		const dda::Grid grid = MakeGrid(corner_size, density, random);
+		const dda::DistanceField distance_field(grid.GetView());
+		const dda::GridView view = distance_field.Attach(grid.GetView());
+
+		std::vector<Vector2d<float>> origins;
+		std::vector<Vector2d<float>> directions;
+		MakeRays(corner_size, corner_origins, random, origins, directions);
+
+		std::vector<dda::VisibilityPolygon> polygons(corner_origins);
+
+		for (const Scenario& scenario : scenarios)
+		{
+			const float max_distance = scenario.max_cells_ > 0.0f ? scenario.max_cells_ * cell_size : 1e30f;
+
+			const auto cast = [&](dda::Kernel kernel)
+			{
+				for (std::size_t i = 0; i < corner_origins; ++i)
+				{
+					dda::CastCorners(view, origins[i], std::atan2(directions[i].y, directions[i].x), full_circle, max_distance, polygons[i], 64, kernel);
+				}
+			};
+
+			const auto digest_polygons = [&](std::size_t& hits, std::uint64_t& checksum)
+			{
+				for (const dda::VisibilityPolygon& polygon : polygons)
+				{
+					Digest(polygon, hits, checksum);
+				}
+			};
+
+			std::size_t scalar_rays = 0;
+			std::uint64_t scalar_checksum = checksum_seed;
+			cast(dda::Kernel::scalar);
+			digest_polygons(scalar_rays, scalar_checksum);
+
+			fprintf(stderr, "%dx%d density %d%% %s corners\n", corner_size.width_, corner_size.height_, density, scenario.name_);
+
+			const Measurement measurement = Measure({ "corners", [&] { cast(dda::Kernel::automatic); }, digest_polygons }, options.min_seconds_);
+
+			printf("%s\n    { \"width\": %d, \"height\": %d, \"density\": %d, \"rays\": \"%s\", \"method\": \"corners\", ", first ? "" : ",", corner_size.width_, corner_size.height_, density, scenario.name_);
+			printf("\"seconds\": %.9f, \"repetitions\": %zu, \"rays_per_second\": %.0f, ", measurement.seconds_, measurement.repetitions_, static_cast<double>(measurement.hits_) / measurement.seconds_);
+			printf("\"hits\": %zu, \"checksum\": \"%016llx\", \"matches_scalar\": %s }", measurement.hits_, static_cast<unsigned long long>(measurement.checksum_), measurement.checksum_ == scalar_checksum ? "true" : "false");
+			fflush(stdout);
+			first = false;
+		}
+	}
+
+	printf("\n  ]\n}\n");
+
+	if (options.gpu_)
+	{
+		gpu_caster.reset();
+		DestroyGpuContext();
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "GpuContext.hpp"
+
+#ifdef DDA_BENCH_GPU
+
+#include <SDL2/SDL.h>
+
+#include <cstdio>
+
+namespace
+{
+	SDL_Window* window = nullptr;
+	SDL_GLContext context = nullptr;
+} // namespace
+
+dda::GpuCaster::LoadProc CreateGpuContext()
+{
+	if (SDL_Init(SDL_INIT_VIDEO) < 0)
+	{
+		fprintf(stderr, "SDL could not be initialized! SDL Error: %s\n", SDL_GetError());
+		return nullptr;
+	}
+
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+	window = SDL_CreateWindow("dda_bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	context = window != nullptr ? SDL_GL_CreateContext(window) : nullptr;
+
+	if (context == nullptr)
+	{
+		fprintf(stderr, "OpenGL 4.3 context could not be created! SDL Error: %s\n", SDL_GetError());
+		DestroyGpuContext();
+		return nullptr;
+	}
+
+	return &SDL_GL_GetProcAddress;
+}
+
+void DestroyGpuContext()
+{
+	SDL_GL_DeleteContext(context);
+	context = nullptr;
+
+	SDL_DestroyWindow(window);
+	window = nullptr;
+
+	SDL_Quit();
+}
+
+#else
+
+dda::GpuCaster::LoadProc CreateGpuContext()
+{
+	return nullptr;
+}
+
+void DestroyGpuContext()
+{
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef BENCH_GPU_CONTEXT_HPP
+#define BENCH_GPU_CONTEXT_HPP
+
+#include "dda/GpuCaster.hpp"
+
+/*
+ * Makes the OpenGL 4.3 context of a hidden window current and returns its
+ * loader for GpuCaster::Initialize. Returns nullptr if no such context can
+ * be made, or if the bench was built without BENCH_GPU=1 and so without SDL.
+ */
+dda::GpuCaster::LoadProc CreateGpuContext();
+
+void DestroyGpuContext();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef AGENTS_HPP
+#define AGENTS_HPP
+
+#include "dda/GpuCaster.hpp"
+#include "dda/Grid.hpp"
+#include "dda/HitMarks.hpp"
+#include "dda/JobPool.hpp"
+#include "dda/Kernel.hpp"
+#include "dda/RayCaster.hpp"
+#include "Vector2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Crowd of point agents for load-testing the simulation. Each field is
+ * its own array, so the movement pass streams positions and velocities
+ * while the casts read them straight as the batch's origins and
+ * directions. Every tick each agent moves by its velocity, bouncing off
+ * walls and the map edge one axis at a time, then casts a ray along its
+ * heading; both passes are split across a JobPool.
+ */
+class Agents
+{
+private:
+	std::vector<Vector2d<float>> positions_;
+	std::vector<Vector2d<float>> velocities_;
+	std::vector<dda::RayHit> hits_;
+
+public:
+	/* Replaces the crowd with count agents on random empty cells, heading in random directions at speed world units per tick. */
+	void Spawn(const dda::GridView& grid, std::size_t count, float speed, std::uint32_t seed);
+
+	/*
+	 * The rays go to gpu if it is given, which must have grid set, and
+	 * across pool with kernel otherwise. The cells they hit are marked in
+	 * marks, if given, by the jobs of pool.
+	 */
+	void Tick(const dda::GridView& grid, dda::JobPool& pool, float max_distance, dda::Kernel kernel = dda::Kernel::automatic, dda::GpuCaster* gpu = nullptr, dda::HitMarks* marks = nullptr);
+
+	std::size_t GetCount() const;
+
+	const std::vector<Vector2d<float>>& GetPositions() const;
+
+	/* hits[i] is where agent i's ray of the last tick stopped. */
+	const std::vector<dda::RayHit>& GetHits() const;
+};
+
+#endif
\ No newline at end of file
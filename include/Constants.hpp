@@ -6,6 +6,8 @@ namespace constants
 	inline constexpr char game_title[] = "DDA tech demo"; 
 	inline constexpr int screen_width = 960;
 	inline constexpr int screen_height = 640;
+	inline constexpr float pi = 3.14159265358979323846f;
+	inline constexpr double tick_seconds = 1.0 / 60.0;
 } // namespace constants
 
 #endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef CONTROLS_HPP
+#define CONTROLS_HPP
+
+#include <SDL2/SDL.h>
+
+enum class FanMode
+{
+	off,
+	fan,
+	corners
+};
+
+/* Input gathered by HandleEvents on the main thread for the simulation. */
+struct Controls
+{
+	int vx_;
+	int vy_;
+	SDL_Rect mouse_box_;
+	bool mouse_left_pressed_;
+	FanMode fan_mode_;
+	float fan_spread_;
+};
+
+struct WallEdit
+{
+	int x_;
+	int y_;
+	bool wall_;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <chrono>
+
+enum class PacingMode
+{
+	vsync,
+	capped,
+	uncapped
+};
+
+const char* GetPacingModeName(PacingMode mode);
+
+/*
+ * Decides how long the main loop waits between frames. With vsync the
+ * wait happens in SDL_RenderPresent, capped sleeps until the next frame
+ * slot and uncapped does not wait at all, for benchmarking. Frame slots
+ * are absolute, so oversleeping one frame shortens the next wait instead
+ * of drifting.
+ */
+class FramePacer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+private:
+	PacingMode mode_;
+	Clock::duration frame_period_;
+	Clock::time_point next_frame_;
+
+public:
+	FramePacer(PacingMode mode, int fps);
+
+	PacingMode GetMode() const;
+
+	void SetMode(PacingMode mode);
+
+	void SetFps(int fps);
+
+	/* Called once per frame after presenting. */
+	void Wait();
+};
+
+#endif
\ No newline at end of file
@@ -1,16 +1,35 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
+#include "Agents.hpp"
+#include "Controls.hpp"
+#include "FramePacer.hpp"
+#include "Profiler.hpp"
+#include "Recording.hpp"
+#include "TripleBuffer.hpp"
+#include "dda/DistanceField.hpp"
+#include "dda/GpuCaster.hpp"
+#include "dda/Grid.hpp"
+#include "dda/HitMarks.hpp"
+#include "dda/Visibility.hpp"
+
 #include <SDL2/SDL.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
-#include <cmath>
 
-struct Cell
+/* Maps world point p to the screen at (p - position_) * zoom_. */
+struct Camera
 {
-	SDL_Rect rect_;
-	bool is_wall_;
-	bool highlighted_;
+	Vector2d<float> position_;
+	float zoom_;
 };
 
 struct PlayerBox
@@ -21,58 +40,164 @@ struct PlayerBox
 	int vy_;
 };
 
-template <typename T>
-class Vector2d
+/* A tile of walls that changed, and the walls version the change made. */
+struct WallTileChange
 {
-public:
-	T x;
-	T y;
-
-	void Normalize()
-	{
-		T length = GetLength();
-		x /= length;
-		y /= length;
-	}
-
-	void SetLength(T length)
-	{
-		Normalize();
-		x *= length;
-		y *= length;
-	}
-
-	T GetLength()
-	{
-		return std::sqrt((x * x) + (y * y));
-	}
+	Vector2d<int> tile_;
+	std::uint64_t walls_version_;
+};
+
+/*
+ * Everything Render draws, as of the last tick before it was published.
+ * tick_time_ is when that tick was due; moving objects are drawn between
+ * their previous_ and current positions by how far the frame is past it.
+ */
+struct FrameState
+{
+	std::chrono::steady_clock::time_point tick_time_;
+	PlayerBox previous_player_;
+	PlayerBox player_;
+	SDL_Rect mouse_box_;
+	bool render_line_;
+	SDL_FPoint dda_intersection_;
+	FanMode fan_mode_;
+	dda::VisibilityPolygon visibility_;
+	std::vector<Vector2d<int>> hits_;
+	std::vector<Vector2d<float>> agents_;
+	std::vector<Vector2d<float>> agent_hits_;
+
+	/*
+	 * The walls, as what changed since dirty_since_version_: for each tile
+	 * in wall_tiles_, DirtyRegion's tile size of rows in wall_rows_, each
+	 * the word of that row masked to the tile. Tiles may repeat; the last
+	 * copy is current. Written over walls of dirty_since_version_ or any
+	 * later version, they give the walls of walls_version_.
+	 */
+	std::vector<Vector2d<int>> wall_tiles_;
+	std::vector<std::uint64_t> wall_rows_;
+	std::uint64_t walls_version_;
+	std::uint64_t dirty_since_version_;
 };
 
+/*
+ * The simulation (Tick and the ray casts) and rendering share no mutable
+ * state: input reaches the simulation as Controls and WallEdits under
+ * input_mutex_, and results come back as FrameStates through states_.
+ * By default both run back-to-back on the main thread; pipelined, the
+ * simulation runs on its own thread at the tick rate while the main
+ * thread renders the latest published state.
+ */
 class Game
 {
 private:
 	bool initialized_;
 	bool running_;
+	bool pipelined_;
 	int cell_size_;
 	int cells_width_;
 	int cells_height_;
 
-	bool mouse_left_pressed_;
+	// Main thread.
 	bool mouse_right_pressed_;
+	bool mouse_middle_pressed_;
 	bool setting_walls_;
-	bool render_line_;
-
-	std::vector<Cell> board_;
-	PlayerBox player_;
-	SDL_Rect mouse_box_;
+	bool show_profile_;
+	Controls controls_;
+	std::vector<WallEdit> wall_edits_;
+	std::vector<Vector2d<int>> stroke_cells_;
 	SDL_Point mouse_position_;
-	SDL_FPoint dda_intersection_;
+	Vector2d<float> stroke_end_;
+	Camera camera_;
+
+	std::vector<SDL_Rect> line_rects_;
+	std::vector<SDL_Rect> wall_rects_;
+	std::array<std::vector<SDL_Rect>, 4> block_rects_;
+	std::vector<SDL_Vertex> fan_vertices_;
+	std::vector<int> fan_indices_;
+	std::vector<SDL_Vertex> agent_vertices_;
+	std::vector<int> agent_indices_;
 
 	SDL_Window* window_;
 	SDL_Renderer* renderer_;
+	SDL_Texture* static_layer_;
+	bool static_layer_valid_;
+	Camera static_camera_;
+	// The main thread's copy of the walls, as last drawn; the simulation
+	// reads its version to know which changes the states must still carry.
+	dda::Grid static_grid_;
+	std::atomic<std::uint64_t> static_walls_version_;
+
+	Profiler profiler_;
+	std::vector<SDL_Rect> profile_rects_;
+	std::string profile_path_;
+	std::string map_path_;
+	std::string record_path_;
+	FramePacer pacer_;
+
+	// Shared between the threads.
+	std::mutex input_mutex_;
+	Controls shared_controls_;
+	std::vector<WallEdit> shared_wall_edits_;
+	TripleBuffer<FrameState> states_;
+	std::atomic<bool> simulating_;
+	std::thread simulation_;
+
+	// Simulation.
+	Controls sim_controls_;
+	std::vector<WallEdit> sim_wall_edits_;
+	dda::Grid grid_;
+	std::unique_ptr<dda::HitMarks> hit_marks_;
+	dda::DistanceField distance_field_;
+	std::uint64_t walls_version_;
+	std::vector<WallTileChange> wall_changes_;
+	std::chrono::steady_clock::time_point tick_time_;
+	PlayerBox previous_player_;
+	PlayerBox player_;
+	SDL_FPoint dda_intersection_;
+	int fan_ray_count_;
+	dda::VisibilityPolygon visibility_;
+	std::size_t agent_count_;
+	Agents agents_;
+	std::unique_ptr<dda::JobPool> agent_pool_;
+	Recorder recorder_;
+	bool use_gpu_;
+	SDL_Window* gpu_window_;
+	SDL_GLContext gpu_context_;
+	std::unique_ptr<dda::GpuCaster> gpu_caster_;
+	std::uint64_t gpu_walls_version_;
+	Profiler sim_profiler_;
+
+	Profiler& GetSimulationProfiler();
+
+	SDL_FPoint ToScreen(float x, float y) const;
+
+	Vector2d<float> ToWorld(const SDL_Point& screen) const;
+
+	/* Screen pixels covered by a rectangle of cells; derived rather than stored per cell. */
+	SDL_Rect GetScreenRect(const SDL_Rect& cells) const;
+
+	/* Cells overlapping the window, clipped to the map. */
+	SDL_Rect GetVisibleCells() const;
+
+	/* 0 to draw single cells, or the pyramid block shift to draw instead when cells shrink below a couple of pixels. */
+	int GetDetailShift() const;
+
+	/* Scales the zoom by factor, keeping the world point under anchor in place. */
+	void Zoom(float factor, const SDL_Point& anchor);
+
+	void MoveMouseBox();
+
+	/* Paints walls along the segment from the end of the stroke so far to screen, which becomes the new end; starting a stroke paints just its cell. */
+	void ExtendStroke(const SDL_Point& screen, bool start);
+
+	/* Replaces the simulation's walls, resizing everything sized by the map. Only while the simulation thread is not running. */
+	void SetWalls(const dda::GridView& walls);
+
+	void SpawnAgents();
 
 public:
-	Game();
+	/* Headless, no window is opened: Run() returns at once and only Replay() does anything. */
+	explicit Game(bool headless = false);
 
 	~Game();
 
@@ -80,19 +205,84 @@ public:
 
 	void Finalize();
 
+	/* Writes per-second phase timings to path; see Profiler::OpenDump. Pipelined, the simulation's go to path with ".sim" before the extension. */
+	bool OpenProfileDump(const char* path);
+
+	/* Runs the simulation on its own thread; takes effect on the next Run(). */
+	void SetPipelined(bool pipelined);
+
+	/* Replaces the walls with the map file at path, which may be larger than the window; F5 saves back to it. */
+	bool LoadMap(const char* path);
+
+	/* Saves the walls as last drawn. */
+	bool SaveMap(const char* path);
+
+	/* Adds a crowd of count agents for load testing, spawned when Run() starts; see Agents. */
+	void SetAgentCount(std::size_t count);
+
+	/* Casts the agents' rays with the OpenGL compute caster, if a 4.3 context can be made; takes effect on the next Run(). */
+	void SetUseGpu(bool use_gpu);
+
+	/* Records the input of every tick of the next Run() to path, starting from the walls and agents it begins with; see Recorder. */
+	void SetRecordPath(const char* path);
+
+	/*
+	 * Runs the ticks of the recording at path back to back, as fast as they
+	 * go, and prints their timings and a checksum of everything they cast
+	 * as JSON. Two builds given the same recording should agree on the
+	 * checksum; the --profile dump, if any, gets one record for the run.
+	 */
+	bool Replay(const char* path);
+
+	/* fps applies to PacingMode::capped. Falls back to capped if vsync cannot be enabled. */
+	void SetFramePacing(PacingMode mode, int fps);
+
 	void Run();
 
 	void HandleEvents();
+
+	/* Hands the controls and wall edits gathered since the last call to the simulation. */
+	void SubmitInput();
+
+	/* Simulation thread loop when pipelined. */
+	void Simulate();
 	
 	void Tick();
 
 	void DigitalDifferentialAnalysis();
+
+	void CastVisibility();
+
+	/* Makes the hidden window and context the GPU caster runs in. Returns false, leaving the agents on the CPU, if either fails. */
+	bool InitializeGpu();
+
+	void TickAgents();
+
+	void PublishState();
 	
-	void Render();
+	void Render(const FrameState& state);
+
+	/* Brings static_grid_ up to date with state's wall tiles, marking the tiles that changed. */
+	void UpdateStaticGrid(const FrameState& state);
 
-	void RenderGrid();
+	void RenderStaticLayer();
+
+	void RenderGrid(const SDL_Rect& cells);
 	
-	void RenderCells();
+	void RenderCells(const SDL_Rect& cells);
+
+	/* Level-of-detail stand-in for RenderCells: one rect per occupied pyramid block, brighter the fuller it is. */
+	void RenderBlocks(const SDL_Rect& cells, int shift);
+
+	/* Highlights the cells the state's casts hit; drawn every frame over the static layer. */
+	void RenderHits(const FrameState& state);
+
+	void RenderVisibility(const FrameState& state);
+
+	/* Every agent and its ray's hit point as quads in one SDL_RenderGeometry call. */
+	void RenderAgents(const FrameState& state);
+
+	void RenderProfileOverlay();
 };
 
 #endif
\ No newline at end of file
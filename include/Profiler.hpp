@@ -0,0 +1,140 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "dda/RayCaster.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+enum class Phase
+{
+	handle_events,
+	tick,
+	dda,
+	agents,
+	render,
+	frame,
+	count
+};
+
+const char* GetPhaseName(Phase phase);
+
+/*
+ * Log-linear histogram of non-negative integers: values below 8 are exact,
+ * larger ones fall into 8 buckets per power of two, so a percentile is
+ * reported to within 12.5%. Adding a value never allocates.
+ */
+class Histogram
+{
+private:
+	static constexpr int sub_bucket_bits = 3;
+	static constexpr int sub_buckets = 1 << sub_bucket_bits;
+	static constexpr int bucket_count = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+	std::array<std::uint32_t, bucket_count> counts_;
+	std::uint64_t count_;
+	std::uint64_t max_;
+
+	static int GetBucket(std::uint64_t value);
+
+	static std::uint64_t GetBucketUpperBound(int bucket);
+
+public:
+	Histogram();
+
+	void Add(std::uint64_t value);
+
+	void Clear();
+
+	std::uint64_t GetCount() const;
+
+	std::uint64_t GetMax() const;
+
+	/* Upper bound of the bucket holding the given percentile in [0, 100], capped at GetMax(). */
+	std::uint64_t GetPercentile(double percentile) const;
+};
+
+/*
+ * Per-frame timings of the hot phases of Game::Run. Phase times are
+ * accumulated between BeginFrame and EndFrame, since Tick and the DDA can
+ * run several times or not at all in one frame, and the frame totals go
+ * into one histogram per phase. Tick includes the DDA it triggers.
+ *
+ * The histograms cover the interval since the last Dump; a ring of the
+ * most recent frames is kept separately for the overlay graph.
+ */
+class Profiler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static constexpr int history_size = 240;
+
+	using FrameTimes = std::array<std::int64_t, static_cast<int>(Phase::count)>;
+
+	/* Adds the time until it goes out of scope to the current frame. */
+	class Scope
+	{
+	private:
+		Profiler& profiler_;
+		Phase phase_;
+		Clock::time_point start_;
+
+	public:
+		Scope(Profiler& profiler, Phase phase);
+
+		Scope(const Scope&) = delete;
+
+		Scope& operator=(const Scope&) = delete;
+
+		~Scope();
+	};
+
+private:
+	std::array<Histogram, static_cast<int>(Phase::count)> phases_;
+	Histogram steps_;
+	Histogram skips_;
+	std::array<FrameTimes, history_size> history_;
+	int history_next_;
+	FrameTimes current_;
+	Clock::time_point frame_start_;
+	Clock::time_point interval_start_;
+	std::FILE* dump_;
+	bool dump_json_;
+
+public:
+	Profiler();
+
+	~Profiler();
+
+	Profiler(const Profiler&) = delete;
+
+	Profiler& operator=(const Profiler&) = delete;
+
+	Scope Measure(Phase phase);
+
+	void Add(Phase phase, Clock::duration duration);
+
+	void AddRay(const dda::RayStats& stats);
+
+	void BeginFrame();
+
+	void EndFrame();
+
+	/* Frame times in nanoseconds, age 0 being the last finished frame. */
+	const FrameTimes& GetFrame(int age) const;
+
+	const Histogram& GetHistogram(Phase phase) const;
+
+	const Histogram& GetStepHistogram() const;
+
+	/* Dumps are JSON lines if path ends in .json and CSV otherwise. */
+	bool OpenDump(const char* path);
+
+	/* Writes one record for the interval since the last call, if a dump is open, and starts a new interval. */
+	void Dump(int frames, int ticks);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef RECORDING_HPP
+#define RECORDING_HPP
+
+#include "Controls.hpp"
+#include "dda/Grid.hpp"
+#include "dda/Span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/*
+ * Session recording layout, all integers in the byte order of the machine
+ * that wrote it (checked through byte_order_):
+ *
+ *   RecordingHeader
+ *   walls  words_per_row_ * height_ uint64, the walls at the first tick
+ *   ticks  per tick a TickRecord, then edit_count_ EditRecords
+ *
+ * A tick's record is the input Tick() consumed, not the raw SDL events,
+ * so replays repeat the session tick for tick however the frames fell.
+ */
+struct RecordingHeader
+{
+	char magic_[8];
+	std::uint32_t byte_order_;
+	std::uint32_t version_;
+	std::int32_t width_;
+	std::int32_t height_;
+	std::int32_t cell_size_;
+	std::int32_t words_per_row_;
+	std::uint64_t agent_count_;
+};
+
+struct TickRecord
+{
+	std::int32_t vx_;
+	std::int32_t vy_;
+	std::int32_t mouse_box_[4];
+	float fan_spread_;
+	std::uint8_t mouse_left_pressed_;
+	std::uint8_t fan_mode_;
+	std::uint8_t padding_[2];
+	std::uint32_t edit_count_;
+};
+
+struct EditRecord
+{
+	std::int32_t x_;
+	std::int32_t y_;
+	std::uint8_t wall_;
+	std::uint8_t padding_[3];
+};
+
+/* Appends ticks to a recording as they happen; the file is complete after every Write. */
+class Recorder
+{
+private:
+	std::FILE* file_;
+
+public:
+	Recorder();
+
+	~Recorder();
+
+	Recorder(const Recorder&) = delete;
+
+	Recorder& operator=(const Recorder&) = delete;
+
+	/* Starts a recording of a session on grid with agent_count agents. */
+	bool Open(const char* path, const dda::GridView& grid, std::size_t agent_count);
+
+	bool IsOpen() const;
+
+	void Write(const Controls& controls, dda::Span<const WallEdit> edits);
+
+	void Close();
+};
+
+/* A recording read back whole; a file cut off mid-tick loses only that tick. */
+class Recording
+{
+private:
+	RecordingHeader header_;
+	std::vector<std::uint64_t> words_;
+	std::vector<Controls> controls_;
+	std::vector<WallEdit> edits_;
+	std::vector<std::size_t> edit_offsets_;
+
+public:
+	Recording();
+
+	bool Load(const char* path);
+
+	/* Walls at the first tick, without a pyramid. */
+	dda::GridView GetWalls() const;
+
+	std::size_t GetAgentCount() const;
+
+	std::size_t GetTickCount() const;
+
+	const Controls& GetControls(std::size_t tick) const;
+
+	dda::Span<const WallEdit> GetEdits(std::size_t tick) const;
+};
+
+#endif
\ No newline at end of file
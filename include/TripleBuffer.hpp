@@ -0,0 +1,62 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+
+/*
+ * Lock-free handoff of T from one writer thread to one reader thread. The
+ * writer fills its slot and publishes it by swapping it with the shared
+ * slot; the reader takes the shared slot whenever a newer one is there.
+ * The third slot is what lets neither side ever wait for the other: the
+ * writer can always publish again, dropping states the reader skipped,
+ * and the reader keeps its slot until it acquires a newer one. Slots are
+ * reused, so the writer must overwrite every field it publishes.
+ */
+template <typename T>
+class TripleBuffer
+{
+private:
+	static constexpr unsigned index_mask = 3;
+	static constexpr unsigned fresh = 4;
+
+	std::array<T, 3> slots_;
+	std::atomic<unsigned> shared_;
+	unsigned write_;
+	unsigned read_;
+
+public:
+	TripleBuffer() : slots_(), shared_(1), write_(0), read_(2)
+	{
+	}
+
+	/* Writer side. */
+	T& GetWriteSlot()
+	{
+		return slots_[write_];
+	}
+
+	void Publish()
+	{
+		write_ = shared_.exchange(write_ | fresh, std::memory_order_acq_rel) & index_mask;
+	}
+
+	/* Reader side. Returns false, keeping the current slot, if nothing was published since the last call. */
+	bool Acquire()
+	{
+		if ((shared_.load(std::memory_order_relaxed) & fresh) == 0)
+		{
+			return false;
+		}
+
+		read_ = shared_.exchange(read_, std::memory_order_acq_rel) & index_mask;
+		return true;
+	}
+
+	const T& GetReadSlot() const
+	{
+		return slots_[read_];
+	}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef VECTOR2D_HPP
+#define VECTOR2D_HPP
+
+#include <cmath>
+
+template <typename T>
+class Vector2d
+{
+public:
+	T x;
+	T y;
+
+	void Normalize()
+	{
+		T length = GetLength();
+		x /= length;
+		y /= length;
+	}
+
+	void SetLength(T length)
+	{
+		Normalize();
+		x *= length;
+		y *= length;
+	}
+
+	T GetLength() const
+	{
+		return std::sqrt((x * x) + (y * y));
+	}
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#ifndef DDA_ARENA_HPP
+#define DDA_ARENA_HPP
+
+#include "dda/Span.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace dda
+{
+	/*
+	 * Bump allocator for per-frame results: Allocate hands out the next
+	 * bytes of a block and Reset takes them all back at once. Nothing is
+	 * freed individually and nothing is destroyed, so only trivially
+	 * destructible types fit. When a frame needs more than the capacity,
+	 * another block is added and the next Reset merges the blocks into one,
+	 * so after the largest frame so far has been seen once, frames allocate
+	 * nothing from the heap.
+	 */
+	class Arena
+	{
+	private:
+		struct Block
+		{
+			std::unique_ptr<unsigned char[]> data_;
+			std::size_t size_;
+		};
+
+		std::vector<Block> blocks_;
+		std::size_t used_;
+		std::size_t spilled_;
+
+		void* AllocateBytes(std::size_t size, std::size_t alignment);
+
+		void ReleaseBytes(const void* end, std::size_t size);
+
+	public:
+		explicit Arena(std::size_t capacity = 0);
+
+		Arena(const Arena&) = delete;
+
+		Arena& operator=(const Arena&) = delete;
+
+		/* count default-initialized Ts, valid until the next Reset. */
+		template <typename T>
+		Span<T> Allocate(std::size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Arena never runs destructors");
+			static_assert(alignof(T) <= alignof(std::max_align_t), "Arena blocks are only aligned for fundamental types");
+
+			T* data = static_cast<T*>(AllocateBytes(count * sizeof(T), alignof(T)));
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				new (data + i) T;
+			}
+
+			return Span<T>(data, count);
+		}
+
+		/* The first count elements of span; the rest is given back if span is the latest allocation. */
+		template <typename T>
+		Span<T> Shrink(Span<T> span, std::size_t count)
+		{
+			if (count < span.size())
+			{
+				ReleaseBytes(span.data() + span.size(), (span.size() - count) * sizeof(T));
+			}
+
+			return span.subspan(0, count);
+		}
+
+		/* Takes back every allocation; the spans handed out so far must no longer be used. */
+		void Reset();
+
+		/* Bytes handed out since the last Reset, including alignment padding. */
+		std::size_t GetUsed() const;
+
+		std::size_t GetCapacity() const;
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
@@ -0,0 +1,122 @@
+#ifndef DDA_CHUNKED_WORLD_HPP
+#define DDA_CHUNKED_WORLD_HPP
+
+#include "dda/Grid.hpp"
+#include "dda/RayCaster.hpp"
+#include "Vector2d.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace dda
+{
+	/*
+	 * A wall grid too large to keep in memory, split into square chunks of
+	 * 2^chunk_shift cells that a loader fills in on demand. At most
+	 * capacity chunks stay resident; the least recently used one is evicted
+	 * to make room. Casts cross chunk boundaries transparently, skip empty
+	 * chunks whole and ask a background thread to prefetch the chunks a ray
+	 * is about to enter.
+	 *
+	 * A ray reaching a chunk that is not resident either waits for it to
+	 * load (Missing::block), or treats the chunk as solid and reports a hit
+	 * at its boundary (Missing::wall), loading it in the background for
+	 * later casts; IsResident tells such hits apart.
+	 *
+	 * Loaders run on the prefetch thread or on a casting thread, never two
+	 * at once for the same chunk.
+	 */
+	class ChunkedWorld
+	{
+	public:
+		/* Fills chunk, already sized and cleared, with the walls of chunk (chunk_x, chunk_y). */
+		using Loader = std::function<void(int chunk_x, int chunk_y, Grid& chunk)>;
+
+		enum class Missing : std::uint8_t
+		{
+			block,
+			wall
+		};
+
+		struct Chunk
+		{
+			Grid grid_;
+			bool empty_;
+		};
+
+	private:
+		int width_;
+		int height_;
+		int cell_size_;
+		int chunk_shift_;
+		std::size_t capacity_;
+		Loader loader_;
+		Missing missing_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable loaded_;
+		std::condition_variable requested_;
+		std::list<std::uint64_t> lru_;
+		std::unordered_map<std::uint64_t, std::pair<std::shared_ptr<const Chunk>, std::list<std::uint64_t>::iterator>> resident_;
+		std::unordered_set<std::uint64_t> loading_;
+		std::deque<std::uint64_t> requests_;
+		bool stopping_;
+		std::thread prefetcher_;
+
+		static std::uint64_t GetKey(int chunk_x, int chunk_y);
+
+		std::shared_ptr<const Chunk> Load(int chunk_x, int chunk_y) const;
+
+		/* Inserts a loaded chunk, evicting as needed; mutex_ must be held. */
+		void Insert(std::uint64_t key, std::shared_ptr<const Chunk> chunk);
+
+		void RunPrefetcher();
+
+	public:
+		ChunkedWorld(int width, int height, int cell_size, int chunk_shift, std::size_t capacity, Loader loader, Missing missing = Missing::block);
+
+		~ChunkedWorld();
+
+		ChunkedWorld(const ChunkedWorld&) = delete;
+
+		ChunkedWorld& operator=(const ChunkedWorld&) = delete;
+
+		int GetWidth() const;
+
+		int GetHeight() const;
+
+		int GetCellSize() const;
+
+		int GetChunkShift() const;
+
+		/* Bounds only, with no cell data; enough for ray setup and clipping. */
+		GridView GetBounds() const;
+
+		/* The chunk, loading or waiting for it per the Missing policy; nullptr if it is outside the world or, with Missing::wall, not resident yet. */
+		std::shared_ptr<const Chunk> Acquire(int chunk_x, int chunk_y);
+
+		/* Queues the chunk for the prefetch thread unless it is resident, loading or outside the world. */
+		void Prefetch(int chunk_x, int chunk_y);
+
+		bool IsResident(int x, int y) const;
+
+		std::size_t GetResidentCount() const;
+
+		/* Same contract as RayCaster::Cast; safe to call from several threads. */
+		RayHit Cast(const Vector2d<float>& origin, const Vector2d<float>& direction, float max_distance);
+
+		/* Loader helper: copies the chunk's cells out of a larger grid, such as a mapped file. */
+		static void CopyChunk(const GridView& source, int chunk_x, int chunk_y, Grid& chunk);
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
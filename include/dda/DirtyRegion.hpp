@@ -0,0 +1,58 @@
+#ifndef DDA_DIRTY_REGION_HPP
+#define DDA_DIRTY_REGION_HPP
+
+#include "dda/Span.hpp"
+#include "Vector2d.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace dda
+{
+	/*
+	 * Set of grid tiles touched by wall edits since the last Clear(). Tiles
+	 * are square blocks of 2^tile_shift cells, the same as the fine blocks
+	 * of the occupancy pyramid. Marking is O(1) and deduplicated, and the
+	 * dirty tiles come back as a list, so consumers such as render caches
+	 * rebuild only what changed instead of rescanning the grid.
+	 */
+	class DirtyRegion
+	{
+	public:
+		static constexpr int tile_shift = 3;
+
+	private:
+		int tiles_width_;
+		int tiles_height_;
+		bool all_;
+
+		std::vector<std::uint8_t> marked_;
+		std::vector<Vector2d<int>> tiles_;
+
+	public:
+		DirtyRegion();
+
+		/* Sized for a grid of width x height cells. */
+		DirtyRegion(int width, int height);
+
+		int GetTilesWidth() const;
+
+		int GetTilesHeight() const;
+
+		void MarkCell(int x, int y);
+
+		/* Marks the whole grid; GetTiles() is not filled in, consumers should check IsAll() first. */
+		void MarkAll();
+
+		bool IsEmpty() const;
+
+		bool IsAll() const;
+
+		/* Tile coordinates, in the order they were first marked. */
+		Span<const Vector2d<int>> GetTiles() const;
+
+		void Clear();
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
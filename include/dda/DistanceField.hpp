@@ -0,0 +1,54 @@
+#ifndef DDA_DISTANCE_FIELD_HPP
+#define DDA_DISTANCE_FIELD_HPP
+
+#include "dda/DirtyRegion.hpp"
+#include "dda/Grid.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace dda
+{
+	/*
+	 * Chebyshev distance from every cell to its nearest wall, in cells and
+	 * capped at max_clearance: walls are 0, and a cell of clearance d has
+	 * no wall in the square of 2d - 1 cells centred on it. Kernel::
+	 * distance_field jumps rays across those squares, an alternative to
+	 * the pyramid's aligned blocks that also reaches into the open space
+	 * around walls. An edit changes the field only within max_clearance
+	 * cells of it, so Update recomputes just the squares around the dirty
+	 * tiles.
+	 */
+	class DistanceField
+	{
+	public:
+		static constexpr int max_clearance = 64;
+
+	private:
+		int width_;
+		int height_;
+		std::vector<std::uint8_t> clearances_;
+		std::vector<std::uint8_t> scratch_;
+
+		/* Recomputes the cells of [min_x, max_x] x [min_y, max_y], which are clipped to the grid. */
+		void Compute(const GridView& grid, int min_x, int min_y, int max_x, int max_y);
+
+	public:
+		DistanceField();
+
+		explicit DistanceField(const GridView& grid);
+
+		void Build(const GridView& grid);
+
+		/* Catches up with the edits in dirty, or rebuilds if it marks everything or grid changed size. */
+		void Update(const GridView& grid, const DirtyRegion& dirty);
+
+		/* Clearance of cell (x, y); 0 outside the grid. */
+		int GetClearance(int x, int y) const;
+
+		/* grid with the field attached, for Kernel::distance_field. Both must outlive the view. */
+		GridView Attach(const GridView& grid) const;
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef DDA_FIXED_POINT_HPP
+#define DDA_FIXED_POINT_HPP
+
+#include "dda/Grid.hpp"
+#include "dda/RayCaster.hpp"
+#include "dda/Span.hpp"
+#include "Vector2d.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace dda
+{
+	/* Fractional bits of fixed-point world coordinates and distances. */
+	inline constexpr int fixed_shift = 8;
+
+	using Fixed = std::int32_t;
+
+	struct FixedHit
+	{
+		bool hit_;
+		Vector2d<int> cell_;
+		Vector2d<std::int64_t> point_;
+		std::int64_t distance_;
+		HitFace face_;
+	};
+
+	inline Fixed ToFixed(float value)
+	{
+		return static_cast<Fixed>(std::lround(value * static_cast<float>(1 << fixed_shift)));
+	}
+
+	inline Vector2d<Fixed> ToFixed(const Vector2d<float>& value)
+	{
+		return { ToFixed(value.x), ToFixed(value.y) };
+	}
+
+	inline float FromFixed(std::int64_t value)
+	{
+		return static_cast<float>(value) / static_cast<float>(1 << fixed_shift);
+	}
+
+	/*
+	 * Integer-only DDA for lockstep simulations. Origins, distances and hit
+	 * points are fixed-point world units with fixed_shift fractional bits;
+	 * directions are integer vectors of any length. Axis selection compares
+	 * cross-multiplied boundary distances, so there is no rounding anywhere
+	 * in the loop and every platform produces bit-identical hits. It is
+	 * there for determinism, not speed: on the bench it casts about as many
+	 * rays per second as the float scalar kernel, within 0.7 to 1.5 times
+	 * either way from case to case.
+	 *
+	 * CellShift is log2 of the grid's cell size, which turns cell lookups
+	 * into shifts; it must match grid.cell_size_. Instantiated for shifts
+	 * 0 through 8. Rays stop once they leave the grid, but rays starting
+	 * outside are not clipped and step through the empty cells before it.
+	 */
+	template <int CellShift>
+	FixedHit CastFixed(const GridView& grid, const Vector2d<Fixed>& origin, const Vector2d<Fixed>& direction, std::int64_t max_distance);
+
+	/* Uses the CastFixed specialization for the grid's cell size, or a division-based fallback when it is not a power of two up to 256. */
+	FixedHit CastFixed(const GridView& grid, const Vector2d<Fixed>& origin, const Vector2d<Fixed>& direction, std::int64_t max_distance);
+
+	std::size_t CastFixedBatch(const GridView& grid, Span<const Vector2d<Fixed>> origins, Span<const Vector2d<Fixed>> directions, std::int64_t max_distance, Span<FixedHit> results);
+} // namespace dda
+
+#endif
\ No newline at end of file
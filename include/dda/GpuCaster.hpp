@@ -0,0 +1,65 @@
+#ifndef DDA_GPU_CASTER_HPP
+#define DDA_GPU_CASTER_HPP
+
+#include "dda/Grid.hpp"
+#include "dda/Kernel.hpp"
+#include "dda/RayCaster.hpp"
+#include "dda/Span.hpp"
+#include "Vector2d.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace dda
+{
+	/*
+	 * Casts large ray batches with an OpenGL 4.3 compute shader. The bit-
+	 * packed walls are kept in a shader storage buffer; every cast uploads
+	 * the rays' setups, steps one ray per invocation with the same DDA as
+	 * Kernel::scalar and reads the hits back, which blocks until the GPU is
+	 * done. The library links no OpenGL: Initialize loads what it needs
+	 * through load, e.g. SDL_GL_GetProcAddress, and must be called, like
+	 * every other member, on a thread on which an OpenGL 4.3 context is
+	 * current. Until Initialize succeeds, casts run on the CPU kernels.
+	 */
+	class GpuCaster
+	{
+	public:
+		using LoadProc = void* (*)(const char* name);
+
+	private:
+		struct Device;
+
+		std::unique_ptr<Device> device_;
+		GridView grid_;
+
+	public:
+		GpuCaster();
+
+		~GpuCaster();
+
+		GpuCaster(const GpuCaster&) = delete;
+
+		GpuCaster& operator=(const GpuCaster&) = delete;
+
+		/* Returns false if the context is older than 4.3 or the shader does not build; the caster then stays on the CPU. */
+		bool Initialize(LoadProc load);
+
+		bool IsAvailable() const;
+
+		/* OpenGL renderer string, or an empty string while unavailable. */
+		const char* GetDeviceName() const;
+
+		/*
+		 * Casts from now on go against grid, which must outlive them. Walls
+		 * are copied to the GPU here, so this is called again after every
+		 * change to them.
+		 */
+		void SetGrid(const GridView& grid);
+
+		/* Like RayCaster::CastBatch; falls back to it with fallback while unavailable. */
+		std::size_t CastBatch(Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, Span<RayHit> results, Kernel fallback = Kernel::automatic);
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
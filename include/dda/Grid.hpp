@@ -0,0 +1,127 @@
+#ifndef DDA_GRID_HPP
+#define DDA_GRID_HPP
+
+#include "dda/DirtyRegion.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dda
+{
+	/* Side lengths, as shifts, of the fine (8x8) and coarse (64x64) blocks of the occupancy pyramid. */
+	inline constexpr int fine_block_shift = 3;
+	inline constexpr int coarse_block_shift = 6;
+
+	inline constexpr int BlocksPerSide(int cells, int shift)
+	{
+		return (cells + (1 << shift) - 1) >> shift;
+	}
+
+	/*
+	 * Non-owning, read-only view of a wall grid. Walls are stored as one bit
+	 * per cell: each row starts on a fresh 64-bit word, and bit (x % 64) of
+	 * word (x / 64) holds cell x. Cells are cell_size_ world units wide.
+	 *
+	 * The optional pyramid holds the number of walls in every fine and
+	 * coarse block, row-major, so traversal can skip whole empty blocks.
+	 * Either level may be nullptr. So may clearances_, the per-cell
+	 * distances of an attached DistanceField. Cheap to copy.
+	 */
+	struct GridView
+	{
+		const std::uint64_t* words_;
+		int words_per_row_;
+		int width_;
+		int height_;
+		int cell_size_;
+
+		const std::uint8_t* fine_blocks_;
+		const std::uint16_t* coarse_blocks_;
+		const std::uint8_t* clearances_;
+
+		bool Contains(int x, int y) const
+		{
+			return x >= 0 && x < width_ && y >= 0 && y < height_;
+		}
+
+		/* Cells outside of the grid are never walls. */
+		bool IsWall(int x, int y) const
+		{
+			return Contains(x, y) && ((words_[static_cast<std::size_t>(y) * words_per_row_ + (x >> 6)] >> (x & 63)) & 1) != 0;
+		}
+
+		/* Shift of the largest wall-free pyramid block containing cell (x, y), or 0 if there is none. */
+		int GetEmptyBlockShift(int x, int y) const
+		{
+			if (!Contains(x, y))
+			{
+				return 0;
+			}
+
+			if (coarse_blocks_ != nullptr && coarse_blocks_[static_cast<std::size_t>(y >> coarse_block_shift) * BlocksPerSide(width_, coarse_block_shift) + (x >> coarse_block_shift)] == 0)
+			{
+				return coarse_block_shift;
+			}
+
+			if (fine_blocks_ != nullptr && fine_blocks_[static_cast<std::size_t>(y >> fine_block_shift) * BlocksPerSide(width_, fine_block_shift) + (x >> fine_block_shift)] == 0)
+			{
+				return fine_block_shift;
+			}
+
+			return 0;
+		}
+
+		/* Chebyshev distance from cell (x, y) to the nearest wall, see DistanceField; 0 outside the grid or without a field. */
+		int GetClearance(int x, int y) const
+		{
+			return clearances_ != nullptr && Contains(x, y) ? clearances_[static_cast<std::size_t>(y) * width_ + x] : 0;
+		}
+	};
+
+	inline constexpr int WordsPerRow(int width)
+	{
+		return (width + 63) / 64;
+	}
+
+	class Grid
+	{
+	private:
+		int width_;
+		int height_;
+		int cell_size_;
+		int words_per_row_;
+
+		std::vector<std::uint64_t> words_;
+		std::vector<std::uint8_t> fine_blocks_;
+		std::vector<std::uint16_t> coarse_blocks_;
+
+		DirtyRegion dirty_;
+
+	public:
+		Grid();
+
+		Grid(int width, int height, int cell_size);
+
+		int GetWidth() const;
+
+		int GetHeight() const;
+
+		int GetCellSize() const;
+
+		bool IsWall(int x, int y) const;
+
+		void SetWall(int x, int y, bool wall);
+
+		void Clear();
+
+		GridView GetView() const;
+
+		/* Tiles whose walls changed since the last ClearDirtyRegion(). The bitmap and pyramid are already up to date. */
+		const DirtyRegion& GetDirtyRegion() const;
+
+		void ClearDirtyRegion();
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
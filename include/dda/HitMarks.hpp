@@ -0,0 +1,59 @@
+#ifndef DDA_HIT_MARKS_HPP
+#define DDA_HIT_MARKS_HPP
+
+#include "dda/RayCaster.hpp"
+#include "dda/Span.hpp"
+#include "Vector2d.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace dda
+{
+	/*
+	 * Set of cells hit by the casts of one frame, kept apart from the grid
+	 * so that traversal only ever reads it. Mark is lock-free and may be
+	 * called from any number of threads at once, e.g. from the jobs of a
+	 * parallel cast: a cell's bit is set with an atomic or, and the first
+	 * thread to set it also appends the cell to a list, so that reading and
+	 * clearing the marks cost the number of cells hit rather than the size
+	 * of the grid. Beyond capacity cells the bits are still set but the
+	 * list stops growing.
+	 */
+	class HitMarks
+	{
+	private:
+		int width_;
+		int height_;
+		int words_per_row_;
+		std::size_t capacity_;
+		std::unique_ptr<std::atomic<std::uint64_t>[]> words_;
+		std::unique_ptr<Vector2d<int>[]> cells_;
+		std::atomic<std::size_t> count_;
+
+	public:
+		HitMarks(int width, int height, std::size_t capacity);
+
+		HitMarks(const HitMarks&) = delete;
+
+		HitMarks& operator=(const HitMarks&) = delete;
+
+		/* Cells outside the grid are ignored. Returns whether the cell was not marked before. */
+		bool Mark(int x, int y);
+
+		/* Marks the cell of every hit in hits. */
+		void Mark(Span<const RayHit> hits);
+
+		bool IsMarked(int x, int y) const;
+
+		/* The marked cells in the order they were first marked, up to capacity; only once marking has finished. */
+		Span<const Vector2d<int>> GetCells() const;
+
+		/* Unmarks everything; only once marking has finished. */
+		void Clear();
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
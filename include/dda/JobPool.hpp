@@ -0,0 +1,85 @@
+#ifndef DDA_JOB_POOL_HPP
+#define DDA_JOB_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dda
+{
+	/*
+	 * Fixed set of worker threads that run data-parallel loops. Each loop is
+	 * cut into chunks that are dealt round-robin onto per-worker deques;
+	 * a worker pops from the back of its own deque and, once that is empty,
+	 * steals from the front of the others. This balances loops whose chunks
+	 * vary wildly in cost, such as ray batches mixing short hits with
+	 * full-map misses. The calling thread works as worker 0.
+	 */
+	class JobPool
+	{
+	public:
+		using Job = std::function<void(std::size_t begin, std::size_t end)>;
+
+	private:
+		struct Range
+		{
+			std::size_t begin_;
+			std::size_t end_;
+		};
+
+		struct alignas(64) WorkerQueue
+		{
+			std::mutex mutex_;
+			std::deque<Range> ranges_;
+		};
+
+		std::vector<std::unique_ptr<WorkerQueue>> queues_;
+		std::vector<std::thread> threads_;
+
+		std::mutex submit_mutex_;
+		std::mutex wake_mutex_;
+		std::condition_variable wake_;
+		std::condition_variable done_;
+		std::uint64_t generation_;
+		bool stopping_;
+
+		const Job* job_;
+		std::atomic<std::size_t> remaining_;
+
+		void WorkerLoop(std::size_t worker);
+
+		bool RunOne(std::size_t worker);
+
+		bool Pop(std::size_t worker, Range& range);
+
+		bool Steal(std::size_t thief, Range& range);
+
+	public:
+		/* thread_count includes the calling thread; 0 means one per hardware thread. */
+		explicit JobPool(unsigned thread_count = 0);
+
+		~JobPool();
+
+		JobPool(const JobPool&) = delete;
+
+		JobPool& operator=(const JobPool&) = delete;
+
+		unsigned GetThreadCount() const;
+
+		/*
+		 * Calls job(begin, end) over [0, count) in chunks of at most
+		 * chunk_size and returns once every chunk has run. Loops from
+		 * different threads are serialized.
+		 */
+		void ParallelFor(std::size_t count, std::size_t chunk_size, const Job& job);
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef DDA_KERNEL_HPP
+#define DDA_KERNEL_HPP
+
+#include <cstdint>
+
+namespace dda
+{
+	/*
+	 * Traversal kernels for batched casts. The packet kernels step 4 (sse2,
+	 * neon), 8 (avx2) or 16 (avx512) rays in lockstep and return the same
+	 * hits as the scalar kernel. The hierarchical kernel is scalar with
+	 * empty-space skipping over the grid's occupancy pyramid, which suits
+	 * long rays through open maps. The distance_field kernel is scalar too
+	 * and jumps by the clearances of an attached DistanceField instead; on
+	 * grids without one it steps like the scalar kernel.
+	 */
+	enum class Kernel : std::uint8_t
+	{
+		automatic,
+		scalar,
+		hierarchical,
+		distance_field,
+		sse2,
+		avx2,
+		avx512,
+		neon
+	};
+
+	/* True if kernel was built into the library and the running CPU can execute it. */
+	bool IsKernelSupported(Kernel kernel);
+
+	/* Widest supported kernel, detected once from the CPU features. */
+	Kernel GetBestKernel();
+
+	const char* GetKernelName(Kernel kernel);
+} // namespace dda
+
+#endif
\ No newline at end of file
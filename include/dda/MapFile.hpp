@@ -0,0 +1,71 @@
+#ifndef DDA_MAP_FILE_HPP
+#define DDA_MAP_FILE_HPP
+
+#include "dda/Grid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dda
+{
+	/*
+	 * Binary map layout, all integers in the byte order of the machine that
+	 * wrote it (checked through byte_order_):
+	 *
+	 *   MapHeader
+	 *   walls  words_per_row_ * height_ uint64, the GridView bitmap as is
+	 *   fine   uint8 wall count per fine pyramid block
+	 *   coarse uint16 wall count per coarse pyramid block
+	 *
+	 * Each section starts on a 64-byte boundary, so a mapped file can be
+	 * handed to the kernels without copying or rebuilding the pyramid.
+	 */
+	struct MapHeader
+	{
+		char magic_[8];
+		std::uint32_t byte_order_;
+		std::uint32_t version_;
+		std::int32_t width_;
+		std::int32_t height_;
+		std::int32_t cell_size_;
+		std::int32_t words_per_row_;
+		std::uint64_t walls_offset_;
+		std::uint64_t fine_offset_;
+		std::uint64_t coarse_offset_;
+		std::uint64_t file_size_;
+	};
+
+	/* Read-only memory mapping of a map file. Opening validates the header and section bounds, then never touches the payload. */
+	class MapFile
+	{
+	private:
+		void* data_;
+		std::size_t size_;
+		bool mapped_;
+		GridView view_;
+
+	public:
+		MapFile();
+
+		~MapFile();
+
+		MapFile(const MapFile&) = delete;
+
+		MapFile& operator=(const MapFile&) = delete;
+
+		/* Returns false, leaving the map closed, if the file is missing, truncated or not a map. */
+		bool Open(const char* path);
+
+		void Close();
+
+		bool IsOpen() const;
+
+		/* Valid until Close(); the pyramid is the one stored in the file. */
+		GridView GetView() const;
+	};
+
+	/* Writes grid in the layout above, computing the pyramid if the view has none. */
+	bool SaveMap(const char* path, const GridView& grid);
+} // namespace dda
+
+#endif
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef DDA_PROTOCOL_HPP
+#define DDA_PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dda
+{
+	/*
+	 * Wire format of RayService. A TCP connection carries a stream of
+	 * frames and a UDP datagram one or more whole frames. Every frame is a
+	 * FrameHeader followed by size_ bytes of body, always a multiple of 4,
+	 * so the bodies of consecutive frames stay aligned for their floats.
+	 * Integers and floats are little-endian. Each request is answered by
+	 * one response with the same id_, in the order the requests came in.
+	 *
+	 *   cast            CastRequest, count_ origins, count_ directions
+	 *   line_of_sight   LineOfSightRequest, count_ targets
+	 *   edit            count_ EditDelta
+	 *
+	 *   cast_result     count_ HitResult
+	 *   visible_result  (count_ + 31) / 32 uint32; bit i % 32 of word i / 32 is target i
+	 *   edit_result     EditResult
+	 *   error           ErrorResult, count_ is 0
+	 *
+	 * Origins, directions and targets are pairs of floats in world units,
+	 * laid out like Vector2d<float>. A request with any float that is not
+	 * finite is answered with ServiceError::bad_value.
+	 */
+	enum class FrameType : std::uint16_t
+	{
+		cast = 1,
+		line_of_sight = 2,
+		edit = 3,
+		cast_result = 129,
+		visible_result = 130,
+		edit_result = 131,
+		error = 255
+	};
+
+	/*
+	 * Largest body on the wire either way. A header announcing more ends
+	 * the stream; a request whose answer would be larger is answered with
+	 * ServiceError::response_too_large instead.
+	 */
+	inline constexpr std::uint32_t max_frame_body = 1u << 24;
+
+	struct FrameHeader
+	{
+		std::uint32_t size_;
+		std::uint16_t type_;
+		std::uint16_t padding_;
+		std::uint32_t id_;
+		std::uint32_t count_;
+	};
+
+	/* Casts like RayCaster::CastBatch; kernel_ is a Kernel. */
+	struct CastRequest
+	{
+		float max_distance_;
+		std::uint8_t kernel_;
+		std::uint8_t padding_[3];
+	};
+
+	/* Tests HasLineOfSight from origin to every target. */
+	struct LineOfSightRequest
+	{
+		float origin_x_;
+		float origin_y_;
+	};
+
+	/* Sets or clears the wall at cell (x_, y_); cells outside the grid are ignored. */
+	struct EditDelta
+	{
+		std::int32_t x_;
+		std::int32_t y_;
+		std::uint32_t wall_;
+	};
+
+	/* RayHit; face_ is a HitFace. */
+	struct HitResult
+	{
+		std::int32_t cell_x_;
+		std::int32_t cell_y_;
+		float point_x_;
+		float point_y_;
+		float distance_;
+		std::uint8_t hit_;
+		std::uint8_t face_;
+		std::uint8_t padding_[2];
+	};
+
+	/* Walls version after the edits, which every edit frame advances, and the number of cells that changed. */
+	struct EditResult
+	{
+		std::uint64_t version_;
+		std::uint32_t changed_;
+		std::uint32_t padding_;
+	};
+
+	enum class ServiceError : std::uint32_t
+	{
+		malformed_frame = 1,
+		unknown_type = 2,
+		bad_size = 3,
+		bad_kernel = 4,
+		response_too_large = 5,
+		bad_value = 6
+	};
+
+	struct ErrorResult
+	{
+		std::uint32_t error_;
+	};
+
+	static_assert(sizeof(FrameHeader) == 16 && sizeof(CastRequest) == 8 && sizeof(LineOfSightRequest) == 8, "frame layout");
+	static_assert(sizeof(EditDelta) == 12 && sizeof(HitResult) == 24 && sizeof(EditResult) == 16, "frame layout");
+
+	// Frames are copied to and from these structs as they are, without
+	// byte swapping, so the host must share the wire's byte order. MSVC
+	// has no __BYTE_ORDER__, but only targets little-endian machines.
+#if defined(__BYTE_ORDER__)
+	static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the wire format is little-endian and read in place");
+#endif
+} // namespace dda
+
+#endif
\ No newline at end of file
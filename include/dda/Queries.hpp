@@ -0,0 +1,55 @@
+#ifndef DDA_QUERIES_HPP
+#define DDA_QUERIES_HPP
+
+#include "dda/Arena.hpp"
+#include "dda/Grid.hpp"
+#include "dda/Kernel.hpp"
+#include "dda/Span.hpp"
+#include "Vector2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dda
+{
+	/*
+	 * Whether the segment from from to to reaches the cell containing to
+	 * without entering a wall first. The traversal stops at that cell, so
+	 * it costs the segment's length rather than a full cast, and a wall
+	 * there does not block: standing next to a wall, one can see it. As
+	 * with casts, the cell containing from never blocks.
+	 */
+	bool HasLineOfSight(const GridView& grid, const Vector2d<float>& from, const Vector2d<float>& to);
+
+	/*
+	 * HasLineOfSight from origin to every targets[i], into visible[i] as 1
+	 * or 0. The setup shared by all rays from origin is done once, and the
+	 * targets are traversed in order of angle so that consecutive rays
+	 * cross the same cells while they are still in cache. Returns the
+	 * number of targets tested, which is the size of the shorter span.
+	 */
+	std::size_t HasLineOfSight(const GridView& grid, const Vector2d<float>& origin, Span<const Vector2d<float>> targets, Span<std::uint8_t> visible, Kernel kernel = Kernel::automatic);
+
+	/* The same with the results and the sorting scratch in arena, so repeated queries allocate nothing once it has grown to fit them. */
+	Span<std::uint8_t> HasLineOfSight(Arena& arena, const GridView& grid, const Vector2d<float>& origin, Span<const Vector2d<float>> targets, Kernel kernel = Kernel::automatic);
+
+	/*
+	 * Replaces cells with the cells of the grid that overlap the circle of
+	 * radius around center, in row-major order, or just the walls among
+	 * them when walls_only is set; those are read a word of cells at a
+	 * time.
+	 */
+	void FindCellsInRadius(const GridView& grid, const Vector2d<float>& center, float radius, std::vector<Vector2d<int>>& cells, bool walls_only = false);
+
+	/*
+	 * Replaces cells with the cells of the grid that the segment from from
+	 * to to passes through, walls or not, in order from from's cell to
+	 * to's, e.g. to rasterize a stroke between two samples. Consecutive
+	 * cells share an edge, bar ties where the segment passes exactly
+	 * through a grid vertex or ends on a boundary.
+	 */
+	void FindCellsOnSegment(const GridView& grid, const Vector2d<float>& from, const Vector2d<float>& to, std::vector<Vector2d<int>>& cells);
+} // namespace dda
+
+#endif
\ No newline at end of file
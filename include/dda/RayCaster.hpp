@@ -0,0 +1,98 @@
+#ifndef DDA_RAY_CASTER_HPP
+#define DDA_RAY_CASTER_HPP
+
+#include "dda/Arena.hpp"
+#include "dda/Grid.hpp"
+#include "dda/JobPool.hpp"
+#include "dda/Kernel.hpp"
+#include "dda/Span.hpp"
+#include "Vector2d.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dda
+{
+	/* Side of the hit cell through which the ray entered it. */
+	enum class HitFace : std::uint8_t
+	{
+		none,
+		west,
+		east,
+		north,
+		south
+	};
+
+	struct RayHit
+	{
+		bool hit_;
+		Vector2d<int> cell_;
+		Vector2d<float> point_;
+		float distance_;
+		HitFace face_;
+	};
+
+	/* Work done by one cast: cells stepped one at a time and empty pyramid blocks jumped over. */
+	struct RayStats
+	{
+		std::uint32_t steps_;
+		std::uint32_t skips_;
+	};
+
+	/*
+	 * Results of an arena-backed CastBatch, valid until the arena is reset.
+	 * If cells were recorded, cells_[i] lists the cells ray i entered, in
+	 * order and ending with the hit cell; the cell it started in is not
+	 * included. Otherwise cells_ is empty.
+	 */
+	struct RayBatch
+	{
+		Span<RayHit> hits_;
+		Span<Span<const Vector2d<int>>> cells_;
+	};
+
+	/*
+	 * Steps a ray cell by cell through a grid until it enters a wall, leaves
+	 * the grid or travels further than max_distance. Rays starting outside
+	 * the grid begin at their entry point. Origins, hit points and distances
+	 * are in world units, i.e. the same units as GridView::cell_size_.
+	 * The cell containing the origin is never reported as a hit.
+	 */
+	class RayCaster
+	{
+	private:
+		GridView grid_;
+
+	public:
+		explicit RayCaster(const GridView& grid);
+
+		/* Single-ray cast; skips empty pyramid blocks like Kernel::hierarchical. */
+		RayHit Cast(const Vector2d<float>& origin, const Vector2d<float>& direction, float max_distance) const;
+
+		/* Cast that also adds the traversal work to stats. */
+		RayHit Cast(const Vector2d<float>& origin, const Vector2d<float>& direction, float max_distance, RayStats& stats) const;
+
+		/*
+		 * Casts origins[i] along directions[i] into results[i]. Rays are set
+		 * up in chunks before any of them is traversed, so the per-ray setup
+		 * runs in its own tight loop, then traversed by kernel. An unsupported
+		 * kernel falls back to GetBestKernel(). Returns the number of rays
+		 * cast, which is the size of the shortest span.
+		 */
+		std::size_t CastBatch(Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, Span<RayHit> results, Kernel kernel = Kernel::automatic) const;
+
+		/*
+		 * CastBatch into storage from arena, so a frame's casts allocate
+		 * nothing once the arena has grown to fit them. Recording the cells
+		 * steps each ray through every cell it enters, which the skipping
+		 * and packet kernels do not, so kernel is then ignored and the hits
+		 * match Kernel::scalar.
+		 */
+		RayBatch CastBatch(Arena& arena, Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, bool record_cells = false, Kernel kernel = Kernel::automatic) const;
+
+		/* CastBatch split across pool; the grid is shared read-only between workers. */
+		std::size_t CastBatch(JobPool& pool, Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, Span<RayHit> results, Kernel kernel = Kernel::automatic) const;
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef DDA_RAY_SERVICE_HPP
+#define DDA_RAY_SERVICE_HPP
+
+#include "dda/DistanceField.hpp"
+#include "dda/Grid.hpp"
+#include "dda/JobPool.hpp"
+#include "dda/Protocol.hpp"
+#include "dda/RayCaster.hpp"
+#include "dda/Span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dda
+{
+	/*
+	 * Answers the requests of Protocol.hpp against one grid, independent of
+	 * any transport: the server feeds it the bytes it received and sends
+	 * back what it appends. Request bodies are read in place, so casts and
+	 * line-of-sight tests run straight off the receive buffer, split across
+	 * pool. Edits are applied one frame at a time between queries, with the
+	 * pyramid and the distance field brought up to date incrementally, so
+	 * every query sees the edits of all frames before it and none after.
+	 */
+	class RayService
+	{
+	private:
+		JobPool& pool_;
+		Grid grid_;
+		DistanceField distance_field_;
+		std::uint64_t version_;
+
+		std::vector<RayHit> hits_;
+		std::vector<std::uint8_t> visible_;
+
+		void Cast(const FrameHeader& header, Span<const std::uint8_t> body, std::vector<std::uint8_t>& output);
+
+		void TestLineOfSight(const FrameHeader& header, Span<const std::uint8_t> body, std::vector<std::uint8_t>& output);
+
+		void Edit(const FrameHeader& header, Span<const std::uint8_t> body, std::vector<std::uint8_t>& output);
+
+	public:
+		explicit RayService(JobPool& pool);
+
+		RayService(const RayService&) = delete;
+
+		RayService& operator=(const RayService&) = delete;
+
+		/* Serves a copy of walls from now on, with a fresh pyramid and distance field. */
+		void SetWalls(const GridView& walls);
+
+		/* The walls as served, with the distance field attached. */
+		GridView GetView() const;
+
+		std::uint64_t GetVersion() const;
+
+		/*
+		 * Answers the whole frames at the front of input, which must start on
+		 * a 4-byte boundary, appending one response per request to output.
+		 * consumed is set to the bytes answered; a partial frame at the end
+		 * is left for the next call, once the rest has arrived. Returns false
+		 * after answering with ServiceError::malformed_frame if a header
+		 * cannot be delimited, past which the stream cannot be followed.
+		 */
+		bool Serve(Span<const std::uint8_t> input, std::size_t& consumed, std::vector<std::uint8_t>& output);
+	};
+
+	/* Appends an error response to request id. */
+	void AppendError(std::vector<std::uint8_t>& output, std::uint32_t id, ServiceError error);
+} // namespace dda
+
+#endif
\ No newline at end of file
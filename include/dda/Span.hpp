@@ -0,0 +1,79 @@
+#ifndef DDA_SPAN_HPP
+#define DDA_SPAN_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace dda
+{
+	/* Minimal stand-in for std::span, which is not available in C++17. */
+	template <typename T>
+	class Span
+	{
+	private:
+		T* data_;
+		std::size_t size_;
+
+	public:
+		Span() : data_(nullptr), size_(0)
+		{
+		}
+
+		Span(T* data, std::size_t size) : data_(data), size_(size)
+		{
+		}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+		Span(const Span<U>& other) : data_(other.data()), size_(other.size())
+		{
+		}
+
+		template <typename U, typename A, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+		Span(std::vector<U, A>& vector) : data_(vector.data()), size_(vector.size())
+		{
+		}
+
+		template <typename U, typename A, typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+		Span(const std::vector<U, A>& vector) : data_(vector.data()), size_(vector.size())
+		{
+		}
+
+		T* data() const
+		{
+			return data_;
+		}
+
+		std::size_t size() const
+		{
+			return size_;
+		}
+
+		bool empty() const
+		{
+			return size_ == 0;
+		}
+
+		T* begin() const
+		{
+			return data_;
+		}
+
+		T* end() const
+		{
+			return data_ + size_;
+		}
+
+		T& operator[](std::size_t index) const
+		{
+			return data_[index];
+		}
+
+		Span subspan(std::size_t offset, std::size_t count) const
+		{
+			return { data_ + offset, count };
+		}
+	};
+} // namespace dda
+
+#endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef DDA_VISIBILITY_HPP
+#define DDA_VISIBILITY_HPP
+
+#include "dda/Arena.hpp"
+#include "dda/Grid.hpp"
+#include "dda/Kernel.hpp"
+#include "dda/Span.hpp"
+#include "Vector2d.hpp"
+
+#include <vector>
+
+namespace dda
+{
+	/*
+	 * Outline of what is visible from origin_, as the points_ where rays
+	 * from it stop, in increasing angle. A ray stops at the wall it hits, at
+	 * max_distance or where it leaves the grid. closed_ is set when the
+	 * points cover the full circle, so the last point connects to the first.
+	 * angles_[i] is the angle of the ray that ended at points_[i]. Reusing
+	 * one polygon across frames reuses its storage.
+	 */
+	struct VisibilityPolygon
+	{
+		Vector2d<float> origin_;
+		std::vector<float> angles_;
+		std::vector<Vector2d<float>> points_;
+		bool closed_;
+	};
+
+	/* VisibilityPolygon with its arrays in an arena, valid until the arena is reset. */
+	struct VisibilityView
+	{
+		Vector2d<float> origin_;
+		Span<const float> angles_;
+		Span<const Vector2d<float>> points_;
+		bool closed_;
+	};
+
+	/*
+	 * Casts ray_count rays evenly spread over spread radians centred on
+	 * angle, or over the full circle if spread is at least 2 pi. The setup
+	 * shared by all rays from origin is done once. Angles are measured from
+	 * the +x axis towards +y, i.e. clockwise on screen.
+	 */
+	void CastFan(const GridView& grid, const Vector2d<float>& origin, float angle, float spread, int ray_count, float max_distance, VisibilityPolygon& polygon, Kernel kernel = Kernel::automatic);
+
+	/* CastFan into storage from arena, so repeated fans allocate nothing once the arena has grown to fit them. */
+	VisibilityView CastFan(Arena& arena, const GridView& grid, const Vector2d<float>& origin, float angle, float spread, int ray_count, float max_distance, Kernel kernel = Kernel::automatic);
+
+	/*
+	 * Like CastFan, but casts just to either side of every wall corner and
+	 * grid corner within max_distance, plus the two edges of the arc. The
+	 * outline between such rays is straight, so the polygon is exact, bar
+	 * gaps narrower than the corner rays' offset, with far fewer rays than
+	 * a dense fan. Only a max_distance shorter than the walls is
+	 * approximated, by min_ray_count evenly spaced extra rays. From inside
+	 * the grid only the corners that can be seen are cast to, found by a
+	 * sweep outward from origin that skips the pyramid's empty blocks, so
+	 * the cost follows what is visible rather than the size of the map.
+	 */
+	void CastCorners(const GridView& grid, const Vector2d<float>& origin, float angle, float spread, float max_distance, VisibilityPolygon& polygon, int min_ray_count = 64, Kernel kernel = Kernel::automatic);
+} // namespace dda
+
+#endif
\ No newline at end of file
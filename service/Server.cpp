@@ -0,0 +1,319 @@
+#include "Server.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	constexpr std::size_t receive_size = 64 * 1024;
+
+	/* Largest UDP payload over IPv4. */
+	constexpr std::size_t max_datagram = 65507;
+
+	/* Datagrams served per wake-up, so a flood of them cannot starve the connections. */
+	constexpr int datagram_batch = 64;
+
+	bool SetNonBlocking(int handle)
+	{
+		const int flags = fcntl(handle, F_GETFL, 0);
+		return flags >= 0 && fcntl(handle, F_SETFL, flags | O_NONBLOCK) == 0;
+	}
+
+	int OpenSocket(int type, std::uint16_t port)
+	{
+		const int handle = socket(AF_INET, type, 0);
+
+		if (handle < 0)
+		{
+			return -1;
+		}
+
+		const int yes = 1;
+		setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(port);
+
+		if (bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || !SetNonBlocking(handle) || (type == SOCK_STREAM && listen(handle, SOMAXCONN) != 0))
+		{
+			const int error = errno;
+			close(handle);
+			errno = error;
+			return -1;
+		}
+
+		return handle;
+	}
+
+	/* Id of the first frame in bytes, to answer with when the frames cannot be answered one by one. */
+	std::uint32_t GetFirstId(const std::uint8_t* bytes, std::size_t size)
+	{
+		dda::FrameHeader header = {};
+
+		if (size >= sizeof(dda::FrameHeader))
+		{
+			std::memcpy(&header, bytes, sizeof(dda::FrameHeader));
+		}
+
+		return header.id_;
+	}
+} // namespace
+
+Server::Server(dda::RayService& service) : service_(service), listener_(-1), datagram_socket_(-1), datagram_(max_datagram)
+{
+}
+
+Server::~Server()
+{
+	for (const Connection& connection : connections_)
+	{
+		close(connection.socket_);
+	}
+
+	if (listener_ >= 0)
+	{
+		close(listener_);
+	}
+
+	if (datagram_socket_ >= 0)
+	{
+		close(datagram_socket_);
+	}
+}
+
+bool Server::ListenTcp(std::uint16_t port)
+{
+	listener_ = OpenSocket(SOCK_STREAM, port);
+
+	if (listener_ < 0)
+	{
+		fprintf(stderr, "TCP port %u could not be opened: %s\n", port, std::strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+bool Server::ListenUdp(std::uint16_t port)
+{
+	datagram_socket_ = OpenSocket(SOCK_DGRAM, port);
+
+	if (datagram_socket_ < 0)
+	{
+		fprintf(stderr, "UDP port %u could not be opened: %s\n", port, std::strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+void Server::Run(const volatile std::sig_atomic_t& stop)
+{
+	std::vector<pollfd> handles;
+
+	while (stop == 0)
+	{
+		// Closed sockets are -1, which poll skips.
+		handles.clear();
+		handles.push_back({ listener_, POLLIN, 0 });
+		handles.push_back({ datagram_socket_, POLLIN, 0 });
+
+		for (const Connection& connection : connections_)
+		{
+			const std::size_t pending = connection.output_.size() - connection.sent_;
+			const short events = static_cast<short>((!connection.closing_ && pending < max_pending ? POLLIN : 0) | (pending != 0 ? POLLOUT : 0));
+			handles.push_back({ connection.socket_, events, 0 });
+		}
+
+		if (poll(handles.data(), handles.size(), -1) < 0)
+		{
+			if (errno != EINTR)
+			{
+				fprintf(stderr, "poll failed: %s\n", std::strerror(errno));
+				return;
+			}
+
+			continue;
+		}
+
+		std::size_t kept = 0;
+
+		for (std::size_t i = 0; i < connections_.size(); ++i)
+		{
+			Connection& connection = connections_[i];
+			const short events = handles[i + 2].revents;
+			bool open = true;
+
+			if ((events & (POLLIN | POLLHUP | POLLERR)) != 0)
+			{
+				open = Receive(connection);
+			}
+			else if ((events & POLLOUT) != 0)
+			{
+				open = Send(connection);
+			}
+
+			if (!open)
+			{
+				close(connection.socket_);
+				continue;
+			}
+
+			if (kept != i)
+			{
+				connections_[kept] = std::move(connection);
+			}
+
+			++kept;
+		}
+
+		connections_.erase(connections_.begin() + kept, connections_.end());
+
+		if ((handles[1].revents & POLLIN) != 0)
+		{
+			ServeDatagrams();
+		}
+
+		// Last, as it adds connections that were not polled.
+		if ((handles[0].revents & POLLIN) != 0)
+		{
+			Accept();
+		}
+	}
+}
+
+void Server::Accept()
+{
+	for (;;)
+	{
+		const int handle = accept(listener_, nullptr, nullptr);
+
+		if (handle < 0)
+		{
+			return;
+		}
+
+		if (!SetNonBlocking(handle))
+		{
+			close(handle);
+			continue;
+		}
+
+		// Answers are written whole, so there is nothing to gain from
+		// holding back their last segment.
+		const int yes = 1;
+		setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+		connections_.push_back({ handle, {}, 0, {}, 0, false });
+	}
+}
+
+bool Server::Receive(Connection& connection)
+{
+	if (!connection.closing_)
+	{
+		if (connection.input_.size() - connection.received_ < receive_size)
+		{
+			connection.input_.resize(connection.received_ + receive_size);
+		}
+
+		const ssize_t received = recv(connection.socket_, connection.input_.data() + connection.received_, connection.input_.size() - connection.received_, 0);
+
+		if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			return false;
+		}
+
+		// After the client shuts down its side, whatever it sent before is
+		// still answered.
+		if (received == 0)
+		{
+			connection.closing_ = true;
+		}
+
+		if (received > 0)
+		{
+			connection.received_ += static_cast<std::size_t>(received);
+
+			// Every complete request received so far is answered straight
+			// from the buffer; only a trailing partial one is moved to its
+			// front.
+			std::size_t consumed = 0;
+
+			if (!service_.Serve({ connection.input_.data(), connection.received_ }, consumed, connection.output_))
+			{
+				connection.closing_ = true;
+			}
+
+			std::memmove(connection.input_.data(), connection.input_.data() + consumed, connection.received_ - consumed);
+			connection.received_ -= consumed;
+		}
+	}
+
+	return Send(connection);
+}
+
+bool Server::Send(Connection& connection)
+{
+	while (connection.sent_ < connection.output_.size())
+	{
+		const ssize_t sent = send(connection.socket_, connection.output_.data() + connection.sent_, connection.output_.size() - connection.sent_, 0);
+
+		if (sent < 0)
+		{
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		}
+
+		connection.sent_ += static_cast<std::size_t>(sent);
+	}
+
+	connection.output_.clear();
+	connection.sent_ = 0;
+	return !connection.closing_;
+}
+
+void Server::ServeDatagrams()
+{
+	for (int i = 0; i < datagram_batch; ++i)
+	{
+		sockaddr_storage from;
+		socklen_t from_size = sizeof(from);
+		const ssize_t received = recvfrom(datagram_socket_, datagram_.data(), datagram_.size(), 0, reinterpret_cast<sockaddr*>(&from), &from_size);
+
+		if (received < 0)
+		{
+			return;
+		}
+
+		const std::size_t size = static_cast<std::size_t>(received);
+		std::size_t consumed = 0;
+		reply_.clear();
+
+		// A datagram holds whole frames, so a partial one at its end can
+		// never be completed.
+		if (service_.Serve({ datagram_.data(), size }, consumed, reply_) && consumed != size)
+		{
+			dda::AppendError(reply_, GetFirstId(datagram_.data() + consumed, size - consumed), dda::ServiceError::malformed_frame);
+		}
+
+		if (reply_.size() > max_datagram)
+		{
+			reply_.clear();
+			dda::AppendError(reply_, GetFirstId(datagram_.data(), size), dda::ServiceError::response_too_large);
+		}
+
+		sendto(datagram_socket_, reply_.data(), reply_.size(), 0, reinterpret_cast<const sockaddr*>(&from), from_size);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef SERVICE_SERVER_HPP
+#define SERVICE_SERVER_HPP
+
+#include "dda/RayService.hpp"
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Puts a RayService on TCP and UDP sockets with one poll loop, POSIX only.
+ * Each connection's bytes are received into a buffer that the service
+ * reads the requests from in place; a client may send any number of
+ * requests without waiting, and all the complete ones received are
+ * answered in one go. A client that stops reading its answers is no
+ * longer read from once max_pending bytes are queued for it. A datagram
+ * is answered with one datagram, or with a response_too_large error if
+ * the answers do not fit in one.
+ */
+class Server
+{
+public:
+	static constexpr std::size_t max_pending = std::size_t{ 1 } << 24;
+
+private:
+	struct Connection
+	{
+		int socket_;
+		std::vector<std::uint8_t> input_;
+		std::size_t received_;
+		std::vector<std::uint8_t> output_;
+		std::size_t sent_;
+		bool closing_;
+	};
+
+	dda::RayService& service_;
+	int listener_;
+	int datagram_socket_;
+
+	std::vector<Connection> connections_;
+	std::vector<std::uint8_t> datagram_;
+	std::vector<std::uint8_t> reply_;
+
+	void Accept();
+
+	/* Reads all that is available and answers it; false once the connection is finished with. */
+	bool Receive(Connection& connection);
+
+	bool Send(Connection& connection);
+
+	void ServeDatagrams();
+
+public:
+	explicit Server(dda::RayService& service);
+
+	~Server();
+
+	Server(const Server&) = delete;
+
+	Server& operator=(const Server&) = delete;
+
+	bool ListenTcp(std::uint16_t port);
+
+	bool ListenUdp(std::uint16_t port);
+
+	/* Serves until stop is set, e.g. by a signal handler, which must interrupt poll rather than restart it. */
+	void Run(const volatile std::sig_atomic_t& stop);
+};
+
+#endif
\ No newline at end of file
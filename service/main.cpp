@@ -0,0 +1,157 @@
+#include "Server.hpp"
+#include "dda/Grid.hpp"
+#include "dda/JobPool.hpp"
+#include "dda/MapFile.hpp"
+#include "dda/RayService.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	struct Options
+	{
+		const char* map_;
+		int width_;
+		int height_;
+		int cell_size_;
+		int tcp_port_;
+		int udp_port_;
+		unsigned threads_;
+	};
+
+	volatile std::sig_atomic_t stop = 0;
+
+	void Stop(int)
+	{
+		stop = 1;
+	}
+
+	void Usage(const char* program)
+	{
+		fprintf(stderr, "Usage: %s [--map PATH | --size W H] [--cell-size N] [--tcp PORT] [--udp PORT] [--threads N]\n", program);
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options)
+	{
+		options = { nullptr, 1024, 1024, 32, -1, -1, 0 };
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const bool has_value = i + 1 < argc;
+
+			if (std::strcmp(argv[i], "--map") == 0 && has_value)
+			{
+				options.map_ = argv[++i];
+			}
+			else if (std::strcmp(argv[i], "--size") == 0 && i + 2 < argc)
+			{
+				options.width_ = std::atoi(argv[++i]);
+				options.height_ = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--cell-size") == 0 && has_value)
+			{
+				options.cell_size_ = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--tcp") == 0 && has_value)
+			{
+				options.tcp_port_ = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--udp") == 0 && has_value)
+			{
+				options.udp_port_ = std::atoi(argv[++i]);
+			}
+			else if (std::strcmp(argv[i], "--threads") == 0 && has_value)
+			{
+				options.threads_ = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else
+			{
+				Usage(argv[0]);
+				return false;
+			}
+		}
+
+		if (options.tcp_port_ < 0 && options.udp_port_ < 0)
+		{
+			options.tcp_port_ = 7447;
+		}
+
+		if (options.width_ <= 0 || options.height_ <= 0 || options.cell_size_ <= 0 || options.tcp_port_ > 65535 || options.udp_port_ > 65535)
+		{
+			Usage(argv[0]);
+			return false;
+		}
+
+		return true;
+	}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	Options options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	dda::JobPool pool(options.threads_);
+	dda::RayService service(pool);
+	dda::MapFile map;
+
+	if (options.map_ != nullptr)
+	{
+		if (!map.Open(options.map_))
+		{
+			fprintf(stderr, "Map %s could not be loaded!\n", options.map_);
+			return 1;
+		}
+
+		service.SetWalls(map.GetView());
+		map.Close();
+	}
+	else
+	{
+		service.SetWalls(dda::Grid(options.width_, options.height_, options.cell_size_).GetView());
+	}
+
+	Server server(service);
+
+	if ((options.tcp_port_ >= 0 && !server.ListenTcp(static_cast<std::uint16_t>(options.tcp_port_))) || (options.udp_port_ >= 0 && !server.ListenUdp(static_cast<std::uint16_t>(options.udp_port_))))
+	{
+		return 1;
+	}
+
+	// Without SA_RESTART the signals interrupt poll, which then sees stop.
+	struct sigaction action = {};
+	action.sa_handler = Stop;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+
+	// A client that disconnects mid-answer fails the send instead of
+	// killing the service.
+	std::signal(SIGPIPE, SIG_IGN);
+
+	const dda::GridView view = service.GetView();
+	printf("Serving a %dx%d map with %u threads", view.width_, view.height_, pool.GetThreadCount());
+
+	if (options.tcp_port_ >= 0)
+	{
+		printf(", TCP port %d", options.tcp_port_);
+	}
+
+	if (options.udp_port_ >= 0)
+	{
+		printf(", UDP port %d", options.udp_port_);
+	}
+
+	printf("\n");
+	fflush(stdout);
+
+	server.Run(stop);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "Agents.hpp"
+#include "Constants.hpp"
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+	bool IsBlocked(const dda::GridView& grid, float x, float y)
+	{
+		const float cell_size = static_cast<float>(grid.cell_size_);
+		const int cell_x = static_cast<int>(std::floor(x / cell_size));
+		const int cell_y = static_cast<int>(std::floor(y / cell_size));
+
+		return !grid.Contains(cell_x, cell_y) || grid.IsWall(cell_x, cell_y);
+	}
+} // namespace
+
+void Agents::Spawn(const dda::GridView& grid, std::size_t count, float speed, std::uint32_t seed)
+{
+	positions_.clear();
+	velocities_.clear();
+	hits_.clear();
+
+	if (grid.width_ <= 0 || grid.height_ <= 0)
+	{
+		return;
+	}
+
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> cell_x(0, grid.width_ - 1);
+	std::uniform_int_distribution<int> cell_y(0, grid.height_ - 1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// Give up on a crowded grid rather than search it for the last empty cells.
+	const std::size_t attempts = count * 16;
+
+	for (std::size_t attempt = 0; attempt < attempts && positions_.size() < count; ++attempt)
+	{
+		const int x = cell_x(random);
+		const int y = cell_y(random);
+
+		if (grid.IsWall(x, y))
+		{
+			continue;
+		}
+
+		const float angle = unit(random) * 2.0f * constants::pi;
+		positions_.push_back({ (static_cast<float>(x) + unit(random)) * grid.cell_size_, (static_cast<float>(y) + unit(random)) * grid.cell_size_ });
+		velocities_.push_back({ std::cos(angle) * speed, std::sin(angle) * speed });
+	}
+
+	hits_.resize(positions_.size());
+}
+
+void Agents::Tick(const dda::GridView& grid, dda::JobPool& pool, float max_distance, dda::Kernel kernel, dda::GpuCaster* gpu, dda::HitMarks* marks)
+{
+	constexpr std::size_t chunk_size = 1024;
+
+	pool.ParallelFor(positions_.size(), chunk_size, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			Vector2d<float>& position = positions_[i];
+			Vector2d<float>& velocity = velocities_[i];
+
+			if (IsBlocked(grid, position.x + velocity.x, position.y))
+			{
+				velocity.x = -velocity.x;
+			}
+			else
+			{
+				position.x += velocity.x;
+			}
+
+			if (IsBlocked(grid, position.x, position.y + velocity.y))
+			{
+				velocity.y = -velocity.y;
+			}
+			else
+			{
+				position.y += velocity.y;
+			}
+		}
+	});
+
+	if (gpu != nullptr)
+	{
+		gpu->CastBatch(positions_, velocities_, max_distance, hits_);
+	}
+	else
+	{
+		dda::RayCaster(grid).CastBatch(pool, positions_, velocities_, max_distance, hits_, kernel);
+	}
+
+	if (marks != nullptr)
+	{
+		const dda::Span<const dda::RayHit> hits = hits_;
+
+		pool.ParallelFor(hits.size(), chunk_size, [&](std::size_t begin, std::size_t end)
+		{
+			marks->Mark(hits.subspan(begin, end - begin));
+		});
+	}
+}
+
+std::size_t Agents::GetCount() const
+{
+	return positions_.size();
+}
+
+const std::vector<Vector2d<float>>& Agents::GetPositions() const
+{
+	return positions_;
+}
+
+const std::vector<dda::RayHit>& Agents::GetHits() const
+{
+	return hits_;
+}
\ No newline at end of file
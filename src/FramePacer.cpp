@@ -0,0 +1,61 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+const char* GetPacingModeName(PacingMode mode)
+{
+	switch (mode)
+	{
+		case PacingMode::vsync:
+			return "vsync";
+		case PacingMode::capped:
+			return "capped";
+		case PacingMode::uncapped:
+			return "uncapped";
+		default:
+			return "unknown";
+	}
+}
+
+FramePacer::FramePacer(PacingMode mode, int fps) : mode_(mode), next_frame_(Clock::now())
+{
+	SetFps(fps);
+}
+
+PacingMode FramePacer::GetMode() const
+{
+	return mode_;
+}
+
+void FramePacer::SetMode(PacingMode mode)
+{
+	mode_ = mode;
+	next_frame_ = Clock::now();
+}
+
+void FramePacer::SetFps(int fps)
+{
+	frame_period_ = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(fps, 1)));
+}
+
+void FramePacer::Wait()
+{
+	if (mode_ != PacingMode::capped)
+	{
+		return;
+	}
+
+	const Clock::time_point now = Clock::now();
+	next_frame_ += frame_period_;
+
+	// After a long stall, start afresh rather than rushing through the
+	// missed slots.
+	if (next_frame_ < now)
+	{
+		next_frame_ = now;
+		return;
+	}
+
+	std::this_thread::sleep_until(next_frame_);
+}
\ No newline at end of file
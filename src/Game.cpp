@@ -1,42 +1,65 @@
 #include "Game.hpp"
 #include "Constants.hpp"
+#include "Recording.hpp"
+#include "dda/MapFile.hpp"
+#include "dda/Queries.hpp"
+#include "dda/RayCaster.hpp"
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+#include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 
-Game::Game() : 
+namespace
+{
+	/* FNV-1a over the bytes of value, so replays compare results bit for bit. */
+	template <typename T>
+	void Digest(const T& value, std::uint64_t& checksum)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+		{
+			checksum = (checksum ^ bytes[i]) * 0x100000001b3ull;
+		}
+	}
+} // namespace
+
+Game::Game(bool headless) : 
 	initialized_(false), 
 	running_(false), 
+	pipelined_(false), 
 	cell_size_(32), 
 	cells_width_(constants::screen_width / cell_size_), 
 	cells_height_(constants::screen_height / cell_size_), 
-	mouse_left_pressed_(false), 
 	mouse_right_pressed_(false), 
+	mouse_middle_pressed_(false), 
 	setting_walls_(true), 
-	render_line_(false)
+	show_profile_(false), 
+	window_(nullptr), 
+	renderer_(nullptr), 
+	static_layer_(nullptr), 
+	static_layer_valid_(false), 
+	static_grid_(cells_width_, cells_height_, cell_size_), 
+	static_walls_version_(0), 
+	pacer_(PacingMode::vsync, 60), 
+	simulating_(false), 
+	grid_(cells_width_, cells_height_, cell_size_), 
+	hit_marks_(std::make_unique<dda::HitMarks>(cells_width_, cells_height_, 1024)), 
+	distance_field_(grid_.GetView()), 
+	walls_version_(1), 
+	fan_ray_count_(360), 
+	agent_count_(0), 
+	use_gpu_(false), 
+	gpu_window_(nullptr), 
+	gpu_context_(nullptr), 
+	gpu_walls_version_(0)
 {
-	initialized_ = Initialize();
-
-	board_.resize(cells_width_ * cells_height_);
-
-	for (int y = 0; y < cells_height_; ++y)
-	{
-		for (int x = 0; x < cells_width_; ++x)
-		{
-			const int index = y * cells_width_ + x;
-
-			board_[index].rect_.x = x * cell_size_;
-			board_[index].rect_.y = y * cell_size_;
-			board_[index].rect_.w = cell_size_;
-			board_[index].rect_.h = board_[index].rect_.w;
-			board_[index].is_wall_ = false;
-			board_[index].highlighted_ = false;
-		}
-	}
+	initialized_ = !headless && Initialize();
 
 	const int box_size = 10;
 
@@ -46,14 +69,31 @@ Game::Game() :
 	player_.box_.h = box_size;
 	player_.vx_ = 0;
 	player_.vy_ = 0;
-
-	mouse_box_.x = (constants::screen_width * 2 / 3) - (box_size / 2);
-	mouse_box_.y = (constants::screen_height / 2) - (box_size / 2);
-	mouse_box_.w = box_size;
-	mouse_box_.h = box_size;
+	previous_player_ = player_;
+	tick_time_ = std::chrono::steady_clock::now();
+	map_path_ = "map.ddamap";
+
+	controls_.vx_ = 0;
+	controls_.vy_ = 0;
+	controls_.mouse_box_.x = (constants::screen_width * 2 / 3) - (box_size / 2);
+	controls_.mouse_box_.y = (constants::screen_height / 2) - (box_size / 2);
+	controls_.mouse_box_.w = box_size;
+	controls_.mouse_box_.h = box_size;
+	controls_.mouse_left_pressed_ = false;
+	controls_.fan_mode_ = FanMode::off;
+	controls_.fan_spread_ = constants::pi / 2.0f;
+	shared_controls_ = controls_;
+	sim_controls_ = controls_;
 
 	mouse_position_ = { 0, 0 };
+	stroke_end_ = { 0.0f, 0.0f };
+	camera_ = { { 0.0f, 0.0f }, 1.0f };
+	static_camera_ = camera_;
 	dda_intersection_ = { -1.0f, -1.0f };
+
+	PublishState();
+	states_.Acquire();
+	UpdateStaticGrid(states_.GetReadSlot());
 }
 
 Game::~Game()
@@ -82,7 +122,7 @@ bool Game::Initialize()
 		return false;
 	}
 
-	renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED);
+	renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE | SDL_RENDERER_PRESENTVSYNC);
 
 	if (renderer_ == nullptr)
 	{
@@ -90,6 +130,13 @@ bool Game::Initialize()
 		return false;
 	}
 
+	static_layer_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, constants::screen_width, constants::screen_height);
+
+	if (static_layer_ == nullptr)
+	{
+		printf("Warning: Static layer texture could not be created, drawing the grid directly! SDL Error: %s\n", SDL_GetError());
+	}
+
 	constexpr int img_flags = IMG_INIT_PNG;
 
 	if (!(IMG_Init(img_flags) & img_flags))
@@ -103,6 +150,21 @@ bool Game::Initialize()
 
 void Game::Finalize()
 {
+	if (gpu_context_ != nullptr)
+	{
+		// The caster's buffers and program belong to its context.
+		SDL_GL_MakeCurrent(gpu_window_, gpu_context_);
+		gpu_caster_.reset();
+		SDL_GL_DeleteContext(gpu_context_);
+		gpu_context_ = nullptr;
+	}
+
+	SDL_DestroyWindow(gpu_window_);
+	gpu_window_ = nullptr;
+
+	SDL_DestroyTexture(static_layer_);
+	static_layer_ = nullptr;
+
 	SDL_DestroyWindow(window_);
 	window_ = nullptr;
 	
@@ -113,371 +175,1350 @@ void Game::Finalize()
 	IMG_Quit();
 }
 
-void Game::Run()
+bool Game::OpenProfileDump(const char* path)
 {
-	if (!initialized_)
+	if (!profiler_.OpenDump(path))
 	{
-		return;
+		printf("Profile dump %s could not be opened!\n", path);
+		return false;
 	}
 
-	running_ = true;
+	profile_path_ = path;
+	return true;
+}
 
-	constexpr double ms = 1.0 / 60.0;
-	std::uint64_t last_time = SDL_GetPerformanceCounter();
-	long double delta = 0.0;
+void Game::SetPipelined(bool pipelined)
+{
+	pipelined_ = pipelined;
+}
 
-	double timer = SDL_GetTicks();
+bool Game::LoadMap(const char* path)
+{
+	map_path_ = path;
 
-	int frames = 0;
-	int ticks = 0;
+	dda::MapFile map;
 
-	while (running_)
+	if (!map.Open(path))
 	{
-		const std::uint64_t now = SDL_GetPerformanceCounter();
-		const long double elapsed = static_cast<long double>(now - last_time) / static_cast<long double>(SDL_GetPerformanceFrequency());
-
-		last_time = now;
-		delta += elapsed;
-
-		HandleEvents();
-
-		while (delta >= ms)
-		{
-			Tick();
-			delta -= ms;
-			++ticks;
-		}
-
-		//printf("%Lf\n", delta / ms);
-		Render();
-		++frames;
-
-		if (SDL_GetTicks() - timer > 1000.0)
-		{
-			timer += 1000.0;
-			//printf("Frames: %d, Ticks: %d\n", frames, ticks);
-			frames = 0;
-			ticks = 0;
-		}
+		printf("Map %s could not be opened!\n", path);
+		return false;
 	}
+
+	// Called before Run(), so the simulation's state is still ours to edit.
+	SetWalls(map.GetView());
+	return true;
 }
 
-void Game::HandleEvents()
+void Game::SetWalls(const dda::GridView& walls)
 {
-	SDL_Event e;
+	cells_width_ = walls.width_;
+	cells_height_ = walls.height_;
+	grid_ = dda::Grid(cells_width_, cells_height_, cell_size_);
+	hit_marks_ = std::make_unique<dda::HitMarks>(cells_width_, cells_height_, 1024);
 
-	while (SDL_PollEvent(&e) != 0)
+	for (int y = 0; y < walls.height_; ++y)
 	{
-		SDL_GetMouseState(&mouse_position_.x, &mouse_position_.y);
-
-		if (e.type == SDL_QUIT)
-		{
-			running_ = false;
-			return;
-		}
-		else if (e.type == SDL_MOUSEBUTTONDOWN)
-		{
-			if (e.button.button == SDL_BUTTON_LEFT)
-			{
-				render_line_ = true;
-				mouse_left_pressed_ = true;
-			}
-			else if (e.button.button == SDL_BUTTON_RIGHT)
-			{
-				mouse_right_pressed_ = true;
-				const int index = (mouse_position_.y / cell_size_) * cells_width_ + (mouse_position_.x / cell_size_);
-				setting_walls_ = !board_[index].is_wall_;
-				board_[index].is_wall_ = !board_[index].is_wall_;
-			}
-		}
-		else if (e.type == SDL_MOUSEBUTTONUP)
-		{
-			if (e.button.button == SDL_BUTTON_LEFT)
-			{
-				render_line_ = false;
-				mouse_left_pressed_ = false;
-				dda_intersection_ = { -1.0, -1.0 };
-			}
-			else if (e.button.button == SDL_BUTTON_RIGHT)
-			{
-				mouse_right_pressed_ = false;
-			}
-		}
-		
-		if (e.type == SDL_MOUSEMOTION)
+		for (int word = 0; word < walls.words_per_row_; ++word)
 		{
-			mouse_box_.x = mouse_position_.x - mouse_box_.w / 2;
-			mouse_box_.y = mouse_position_.y - mouse_box_.w / 2;
+			std::uint64_t bits = walls.words_[static_cast<std::size_t>(y) * walls.words_per_row_ + word];
 
-			if (mouse_right_pressed_)
+			while (bits != 0)
 			{
-				const int index = (mouse_position_.y / cell_size_) * cells_width_ + (mouse_position_.x / cell_size_);
-				board_[index].is_wall_ = setting_walls_;
+				grid_.SetWall(word * 64 + __builtin_ctzll(bits), y, true);
+				bits &= bits - 1;
 			}
 		}
+	}
 
-		int speed = 5;
-
-		if (e.type == SDL_KEYDOWN)
-		{
-			if (e.key.keysym.sym == SDLK_w)
-			{
-				player_.vy_ = -speed;
-			}
-
-			if (e.key.keysym.sym == SDLK_a)
-			{
-				player_.vx_ = -speed;
-			}
-
-			if (e.key.keysym.sym == SDLK_s)
-			{
-				player_.vy_ = speed;
-			}
-
-			if (e.key.keysym.sym == SDLK_d)
-			{
-				player_.vx_ = speed;
-			}
-		}
-		else if (e.type == SDL_KEYUP)
-		{
-			if (e.key.keysym.sym == SDLK_w)
-			{
-				player_.vy_ = 0;
-			}
+	distance_field_.Build(grid_.GetView());
+	static_grid_ = dda::Grid(cells_width_, cells_height_, cell_size_);
+	static_walls_version_ = 0;
+	static_layer_valid_ = false;
+
+	// grid_'s dirty tiles cover every wall, as seen from the empty static
+	// grid, so the changes start over from there.
+	wall_changes_.clear();
+	++walls_version_;
+	PublishState();
+	states_.Acquire();
+	UpdateStaticGrid(states_.GetReadSlot());
+}
 
-			if (e.key.keysym.sym == SDLK_a)
-			{
-				player_.vx_ = 0;
-			}
+bool Game::SaveMap(const char* path)
+{
+	if (!dda::SaveMap(path, static_grid_.GetView()))
+	{
+		printf("Map %s could not be saved!\n", path);
+		return false;
+	}
 
-			if (e.key.keysym.sym == SDLK_s)
-			{
-				player_.vy_ = 0;
-			}
+	printf("Map saved to %s\n", path);
+	return true;
+}
 
-			if (e.key.keysym.sym == SDLK_d)
-			{
-				player_.vx_ = 0;
-			}
-		}
-	}
+void Game::SetAgentCount(std::size_t count)
+{
+	agent_count_ = count;
 }
 
-void Game::Tick()
+void Game::SetRecordPath(const char* path)
 {
-	player_.box_.x += player_.vx_;
-	player_.box_.y += player_.vy_;
+	record_path_ = path;
+}
 
-	if (mouse_left_pressed_)
-	{
-		DigitalDifferentialAnalysis();
-	}
+void Game::SetUseGpu(bool use_gpu)
+{
+	use_gpu_ = use_gpu;
 }
 
-void Game::DigitalDifferentialAnalysis()
+bool Game::InitializeGpu()
 {
-	Vector2d<float> player_pos = { static_cast<float>(player_.box_.x + (player_.box_.w / 2)), static_cast<float>(player_.box_.y + (player_.box_.h / 2)) };
-	Vector2d<float> mouse_pos = { static_cast<float>(mouse_box_.x + (mouse_box_.w / 2)), static_cast<float>(mouse_box_.y + (mouse_box_.h / 2)) };
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
-	if (player_pos.x < 0 || player_pos.x > constants::screen_width || player_pos.y < 0 || player_pos.y > constants::screen_height)
+	gpu_window_ = SDL_CreateWindow(constants::game_title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	gpu_context_ = gpu_window_ != nullptr ? SDL_GL_CreateContext(gpu_window_) : nullptr;
+	SDL_GL_ResetAttributes();
+
+	if (gpu_context_ == nullptr)
 	{
-		return;
+		printf("OpenGL 4.3 context could not be created, casting on the CPU! SDL Error: %s\n", SDL_GetError());
+		return false;
 	}
 
-	if (mouse_pos.x < 0 || mouse_pos.x > constants::screen_width || mouse_pos.y < 0 || mouse_pos.y > constants::screen_height)
+	gpu_caster_ = std::make_unique<dda::GpuCaster>();
+
+	if (!gpu_caster_->Initialize(&SDL_GL_GetProcAddress))
 	{
-		return;
+		printf("%s\n", "Warning: OpenGL compute is not supported, casting on the CPU!");
+		gpu_caster_.reset();
+		return false;
 	}
 
-	const Vector2d<float> ray_start = { player_pos.x, player_pos.y };
-	
-	Vector2d<float> ray_dir = { mouse_pos.x - player_pos.x, mouse_pos.y - player_pos.y };
-	ray_dir.SetLength(static_cast<float>(cell_size_));
-
-	Vector2d<float> unit_ray_dir = { mouse_pos.x - player_pos.x, mouse_pos.y - player_pos.y };
-	unit_ray_dir.SetLength(1.0);
-	
-	Vector2d<float> ray_step_size = { std::sqrt(1 + ((ray_dir.y / ray_dir.x) * (ray_dir.y / ray_dir.x))), std::sqrt(1 + ((ray_dir.x / ray_dir.y) * (ray_dir.x / ray_dir.y))) };
-	ray_step_size.x *= static_cast<float>(cell_size_);
-	ray_step_size.y *= static_cast<float>(cell_size_);
-	
-	Vector2d<int> map_check = { static_cast<int>(ray_start.x), static_cast<int>(ray_start.y) };
-	map_check.x = map_check.x - (map_check.x % cell_size_);
-	map_check.y = map_check.y - (map_check.y % cell_size_);
+	printf("Casting agent rays on %s\n", gpu_caster_->GetDeviceName());
+	return true;
+}
 
-	Vector2d<float> ray_length = { 0.0f, 0.0f };
-	Vector2d<int> step = { 0, 0 };
+void Game::SetFramePacing(PacingMode mode, int fps)
+{
+	pacer_.SetFps(fps);
 
-	if (ray_dir.x < 0)
+	if (renderer_ != nullptr && SDL_RenderSetVSync(renderer_, mode == PacingMode::vsync ? 1 : 0) != 0)
 	{
-		step.x = -cell_size_;
-		
-		if (static_cast<int>(ray_start.x) % cell_size_ == 0)
+		if (mode == PacingMode::vsync)
 		{
-			ray_length.x = ray_step_size.x;
+			printf("Warning: Vsync could not be enabled, capping the frame rate instead! SDL Error: %s\n", SDL_GetError());
+			mode = PacingMode::capped;
 		}
 		else
 		{
-			ray_length.x = ((ray_start.x - static_cast<float>(map_check.x)) / cell_size_) * ray_step_size.x;
+			printf("Warning: Vsync could not be disabled! SDL Error: %s\n", SDL_GetError());
 		}
 	}
-	else
-	{
-		step.x = cell_size_;
-		ray_length.x = ((static_cast<float>(map_check.x + cell_size_) - ray_start.x) / cell_size_) * ray_step_size.x;
-	}
 
-	if (ray_dir.y < 0)
-	{
-		step.y = -cell_size_;
+	pacer_.SetMode(mode);
+}
 
-		if (static_cast<int>(ray_start.y) % cell_size_ == 0)
-		{
-			ray_length.y = ray_step_size.y;
-		}
-		else
-		{
-			ray_length.y = ((ray_start.y - static_cast<float>(map_check.y)) / cell_size_) * ray_step_size.y;
-		}
-	}
-	else
+Profiler& Game::GetSimulationProfiler()
+{
+	return pipelined_ ? sim_profiler_ : profiler_;
+}
+
+SDL_FPoint Game::ToScreen(float x, float y) const
+{
+	return { (x - camera_.position_.x) * camera_.zoom_, (y - camera_.position_.y) * camera_.zoom_ };
+}
+
+Vector2d<float> Game::ToWorld(const SDL_Point& screen) const
+{
+	return { camera_.position_.x + screen.x / camera_.zoom_, camera_.position_.y + screen.y / camera_.zoom_ };
+}
+
+SDL_Rect Game::GetScreenRect(const SDL_Rect& cells) const
+{
+	// Rounding the edges rather than the size keeps neighbouring rects
+	// seamless at any zoom.
+	const SDL_FPoint top_left = ToScreen(static_cast<float>(cells.x * cell_size_), static_cast<float>(cells.y * cell_size_));
+	const SDL_FPoint bottom_right = ToScreen(static_cast<float>((cells.x + cells.w) * cell_size_), static_cast<float>((cells.y + cells.h) * cell_size_));
+	const int left = static_cast<int>(std::lround(top_left.x));
+	const int top = static_cast<int>(std::lround(top_left.y));
+
+	return { left, top, static_cast<int>(std::lround(bottom_right.x)) - left, static_cast<int>(std::lround(bottom_right.y)) - top };
+}
+
+SDL_Rect Game::GetVisibleCells() const
+{
+	const Vector2d<float> top_left = ToWorld({ 0, 0 });
+	const Vector2d<float> bottom_right = ToWorld({ constants::screen_width, constants::screen_height });
+	const int left = std::max(static_cast<int>(std::floor(top_left.x / cell_size_)), 0);
+	const int top = std::max(static_cast<int>(std::floor(top_left.y / cell_size_)), 0);
+	const int right = std::min(static_cast<int>(std::ceil(bottom_right.x / cell_size_)), cells_width_);
+	const int bottom = std::min(static_cast<int>(std::ceil(bottom_right.y / cell_size_)), cells_height_);
+
+	return { left, top, std::max(right - left, 0), std::max(bottom - top, 0) };
+}
+
+int Game::GetDetailShift() const
+{
+	constexpr float min_pixels = 2.0f;
+	const float cell_pixels = cell_size_ * camera_.zoom_;
+
+	if (cell_pixels >= min_pixels)
 	{
-		step.y = cell_size_;
-		ray_length.y = ((static_cast<float>(map_check.y + cell_size_) - ray_start.y) / cell_size_) * ray_step_size.y;
+		return 0;
 	}
 
-	const SDL_FPoint x_intersection = { ray_start.x + unit_ray_dir.x * ray_length.x, ray_start.y + unit_ray_dir.y * ray_length.x };
-	const SDL_FPoint y_intersection = { ray_start.x + unit_ray_dir.x * ray_length.y, ray_start.y + unit_ray_dir.y * ray_length.y };
+	return cell_pixels * (1 << dda::fine_block_shift) >= min_pixels ? dda::fine_block_shift : dda::coarse_block_shift;
+}
 
-	if (ray_length.x < ray_length.y)
-	{
-		map_check.x = x_intersection.x;
+void Game::Zoom(float factor, const SDL_Point& anchor)
+{
+	constexpr float min_zoom = 1.0f / 1024.0f;
+	constexpr float max_zoom = 8.0f;
 
-		if (ray_dir.x > 0)
-		{
-			map_check.x -= cell_size_;
-		}
+	const Vector2d<float> world = ToWorld(anchor);
 
-		if (static_cast<int>(ray_start.y) % cell_size_ == 0 && ray_dir.y < 0)
-		{
-			map_check.y -= cell_size_;
-		}
-	}
-	else
-	{
-		map_check.x = x_intersection.x;
+	camera_.zoom_ = std::clamp(camera_.zoom_ * factor, min_zoom, max_zoom);
+	camera_.position_ = { world.x - anchor.x / camera_.zoom_, world.y - anchor.y / camera_.zoom_ };
+}
 
-		if (ray_dir.x > 0)
-		{
-			map_check.x -= cell_size_;
-		}
+void Game::ExtendStroke(const SDL_Point& screen, bool start)
+{
+	const Vector2d<float> world = ToWorld(screen);
+	const dda::Grid& walls = static_grid_;
 
-		if (ray_dir.y < 0)
-		{
-			map_check.y = y_intersection.y;
-		}
+	if (start)
+	{
+		stroke_end_ = world;
 	}
 
-	bool tile_found = false;
-	float max_distance = std::max(constants::screen_width, constants::screen_height) * 10.0f;
-	float distance = 0.0f;
-	
-	while (!tile_found && distance < max_distance)
-	{
-		if (ray_length.x < ray_length.y)
-		{
-			map_check.x += step.x;
-			distance = ray_length.x;
-			ray_length.x += ray_step_size.x;
-		}
-		else
-		{
-			map_check.y += step.y;
-			distance = ray_length.y;
-			ray_length.y += ray_step_size.y;
-		}
+	// The first cell is the previous end, already painted, unless the
+	// stroke is just starting.
+	dda::FindCellsOnSegment(walls.GetView(), stroke_end_, world, stroke_cells_);
 
-		const int x_index = (map_check.x / cell_size_);
-		const int y_index = (map_check.y / cell_size_);
-		const int index = (y_index * cells_width_ + x_index);
+	for (std::size_t i = start ? 0 : 1; i < stroke_cells_.size(); ++i)
+	{
+		const Vector2d<int>& cell = stroke_cells_[i];
 
-		if (index >= 0 && index < static_cast<int>(board_.size()))
+		if (walls.IsWall(cell.x, cell.y) != setting_walls_)
 		{
-			if (board_[index].is_wall_)
-			{
-				board_[index].highlighted_ = true;
-				tile_found = true;
-			}
+			wall_edits_.push_back({ cell.x, cell.y, setting_walls_ });
 		}
 	}
 
-	if (tile_found)
-	{
-		dda_intersection_ = { ray_start.x + unit_ray_dir.x * distance, ray_start.y + unit_ray_dir.y * distance };
-	}
-	else
-	{
-		dda_intersection_ = { -1.0, -1.0 };
-	}
+	stroke_end_ = world;
 }
 
-void Game::Render()
+void Game::MoveMouseBox()
 {
-	SDL_RenderSetViewport(renderer_, NULL);
-	SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0x00, 0xff);
-	SDL_RenderClear(renderer_);
+	const Vector2d<float> world = ToWorld(mouse_position_);
 
-	RenderGrid();
-	RenderCells();
+	controls_.mouse_box_.x = static_cast<int>(std::floor(world.x)) - controls_.mouse_box_.w / 2;
+	controls_.mouse_box_.y = static_cast<int>(std::floor(world.y)) - controls_.mouse_box_.h / 2;
+}
 
-	if (dda_intersection_.x != -1.0f && dda_intersection_.y != -1.0f)
+void Game::Run()
+{
+	if (!initialized_)
 	{
-		constexpr float box_size = 10.0f;
-		const SDL_FRect collision_box = { dda_intersection_.x - (box_size / 2), dda_intersection_.y - (box_size / 2), box_size, box_size };
-		SDL_SetRenderDrawColor(renderer_, 0xff, 0xff, 0xff, 0xff);
-		SDL_RenderDrawRectF(renderer_, &collision_box);
+		return;
 	}
 
-	SDL_SetRenderDrawColor(renderer_, 0xff, 0x00, 0x00, 0xff);
-	SDL_RenderFillRect(renderer_, &player_.box_);
+	running_ = true;
 
-	SDL_SetRenderDrawColor(renderer_, 0x00, 0xff, 0x00, 0xff);
-	SDL_RenderFillRect(renderer_, &mouse_box_);
+	// Before the simulation thread starts, so grid_ is still ours to read.
+	SpawnAgents();
 
-	if (render_line_)
+	if (agent_count_ > 0 && use_gpu_ && gpu_caster_ == nullptr)
 	{
-		SDL_SetRenderDrawColor(renderer_, 0x00, 0xff, 0xff, 0xff);
-		SDL_RenderDrawLine(renderer_, player_.box_.x + (player_.box_.w / 2), player_.box_.y + (player_.box_.h / 2), mouse_box_.x + (mouse_box_.w / 2), mouse_box_.y + (mouse_box_.h / 2));
+		InitializeGpu();
 	}
 
-	SDL_RenderPresent(renderer_);
-}
-
-void Game::RenderGrid()
-{
-	SDL_SetRenderDrawColor(renderer_, 0x14, 0x14, 0x14, 0xff);
-
-	for (int y = 1; y < cells_height_; ++y)
+	if (!record_path_.empty() && !recorder_.Open(record_path_.c_str(), grid_.GetView(), agent_count_))
 	{
-		SDL_RenderDrawLine(renderer_, 0, y * cell_size_, constants::screen_width, y * cell_size_);
+		printf("Recording %s could not be opened!\n", record_path_.c_str());
 	}
 
-	for (int x = 1; x < cells_width_; ++x)
+	// The context moves to whichever thread ticks.
+	if (gpu_context_ != nullptr)
 	{
-		SDL_RenderDrawLine(renderer_, x * cell_size_, 0, x * cell_size_, constants::screen_height);
+		SDL_GL_MakeCurrent(gpu_window_, pipelined_ ? nullptr : gpu_context_);
 	}
-}
 
-void Game::RenderCells()
-{
-	for (int i = 0; i < cells_width_ * cells_height_; ++i)
+	if (pipelined_)
 	{
-		if (board_[i].is_wall_)
+		if (!profile_path_.empty())
 		{
-			SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0xff, 0xff);
-			SDL_RenderFillRect(renderer_, &board_[i].rect_);
+			const std::size_t extension = profile_path_.find_last_of('.');
+			const std::string sim_path = extension == std::string::npos ? profile_path_ + ".sim" : profile_path_.substr(0, extension) + ".sim" + profile_path_.substr(extension);
+
+			if (!sim_profiler_.OpenDump(sim_path.c_str()))
+			{
+				printf("Profile dump %s could not be opened!\n", sim_path.c_str());
+			}
 		}
+
+		simulating_ = true;
+		simulation_ = std::thread(&Game::Simulate, this);
 	}
+
+	constexpr double ms = constants::tick_seconds;
+	std::uint64_t last_time = SDL_GetPerformanceCounter();
+	long double delta = 0.0;
+
+	double timer = SDL_GetTicks();
+
+	int frames = 0;
+	int ticks = 0;
+
+	while (running_)
+	{
+		const std::uint64_t now = SDL_GetPerformanceCounter();
+		const long double elapsed = static_cast<long double>(now - last_time) / static_cast<long double>(SDL_GetPerformanceFrequency());
+
+		last_time = now;
+		delta += elapsed;
+
+		profiler_.BeginFrame();
+
+		{
+			const Profiler::Scope scope(profiler_, Phase::handle_events);
+			HandleEvents();
+			SubmitInput();
+		}
+
+		if (!pipelined_)
+		{
+			const bool ticked = delta >= ms;
+
+			while (delta >= ms)
+			{
+				const Profiler::Scope scope(profiler_, Phase::tick);
+				Tick();
+				delta -= ms;
+				++ticks;
+			}
+
+			if (ticked)
+			{
+				tick_time_ = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<long double>(delta));
+				PublishState();
+			}
+		}
+
+		//printf("%Lf\n", delta / ms);
+		{
+			const Profiler::Scope scope(profiler_, Phase::render);
+			states_.Acquire();
+			Render(states_.GetReadSlot());
+		}
+
+		pacer_.Wait();
+		profiler_.EndFrame();
+		++frames;
+
+		if (SDL_GetTicks() - timer > 1000.0)
+		{
+			timer += 1000.0;
+			//printf("Frames: %d, Ticks: %d\n", frames, ticks);
+			profiler_.Dump(frames, ticks);
+			frames = 0;
+			ticks = 0;
+		}
+	}
+
+	if (simulation_.joinable())
+	{
+		simulating_ = false;
+		simulation_.join();
+	}
+}
+
+void Game::SpawnAgents()
+{
+	if (agent_count_ == 0)
+	{
+		return;
+	}
+
+	constexpr float agent_speed = 2.0f;
+
+	if (agent_pool_ == nullptr)
+	{
+		agent_pool_ = std::make_unique<dda::JobPool>();
+	}
+
+	agents_.Spawn(grid_.GetView(), agent_count_, agent_speed, 1);
+
+	// Each ray of a tick marks at most one cell, so with room for all of
+	// them the list of marked cells never drops any.
+	hit_marks_ = std::make_unique<dda::HitMarks>(cells_width_, cells_height_, std::max<std::size_t>(agents_.GetCount() + 1, 1024));
+	printf("Spawned %zu agents on %u threads\n", agents_.GetCount(), agent_pool_->GetThreadCount());
+}
+
+bool Game::Replay(const char* path)
+{
+	using Clock = std::chrono::steady_clock;
+
+	Recording recording;
+
+	if (!recording.Load(path))
+	{
+		printf("Recording %s could not be loaded!\n", path);
+		return false;
+	}
+
+	// Everything a tick depends on comes from the recording: the walls,
+	// the agents, which spawn from a fixed seed, and each tick's input.
+	cell_size_ = recording.GetWalls().cell_size_;
+	SetWalls(recording.GetWalls());
+	agent_count_ = recording.GetAgentCount();
+	SpawnAgents();
+	pipelined_ = false;
+
+	std::uint64_t checksum = 0xcbf29ce484222325ull;
+	std::vector<Vector2d<int>> marked_cells;
+	const Clock::time_point start = Clock::now();
+
+	for (std::size_t tick = 0; tick < recording.GetTickCount(); ++tick)
+	{
+		{
+			const std::lock_guard<std::mutex> lock(input_mutex_);
+			const dda::Span<const WallEdit> edits = recording.GetEdits(tick);
+
+			shared_controls_ = recording.GetControls(tick);
+			shared_wall_edits_.assign(edits.begin(), edits.end());
+		}
+
+		profiler_.BeginFrame();
+
+		{
+			const Profiler::Scope scope(profiler_, Phase::tick);
+			Tick();
+		}
+
+		profiler_.EndFrame();
+		PublishState();
+
+		// Nothing draws a replay, so take the walls here to keep the
+		// simulation's log of wall changes short.
+		states_.Acquire();
+		UpdateStaticGrid(states_.GetReadSlot());
+		static_grid_.ClearDirtyRegion();
+
+		Digest(player_.box_, checksum);
+		Digest(dda_intersection_, checksum);
+
+		// The agents' jobs mark cells in whatever order they run.
+		marked_cells.assign(hit_marks_->GetCells().begin(), hit_marks_->GetCells().end());
+		std::sort(marked_cells.begin(), marked_cells.end(), [](const Vector2d<int>& a, const Vector2d<int>& b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+
+		for (const Vector2d<int>& cell : marked_cells)
+		{
+			Digest(cell, checksum);
+		}
+
+		if (sim_controls_.fan_mode_ != FanMode::off)
+		{
+			for (const Vector2d<float>& point : visibility_.points_)
+			{
+				Digest(point, checksum);
+			}
+		}
+
+		for (const dda::RayHit& hit : agents_.GetHits())
+		{
+			Digest(hit.cell_, checksum);
+			Digest(hit.distance_, checksum);
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	const std::size_t ticks = recording.GetTickCount();
+
+	printf("{ \"replay\": \"%s\", \"ticks\": %zu, \"agents\": %zu, \"seconds\": %.6f, \"ticks_per_second\": %.1f", path, ticks, agents_.GetCount(), seconds, seconds > 0.0 ? static_cast<double>(ticks) / seconds : 0.0);
+
+	for (const Phase phase : { Phase::tick, Phase::dda, Phase::agents })
+	{
+		const Histogram& histogram = profiler_.GetHistogram(phase);
+		printf(", \"%s_us\": { \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f }", GetPhaseName(phase), histogram.GetPercentile(50.0) / 1000.0, histogram.GetPercentile(99.0) / 1000.0, histogram.GetMax() / 1000.0);
+	}
+
+	printf(", \"checksum\": \"%016llx\" }\n", static_cast<unsigned long long>(checksum));
+	profiler_.Dump(0, static_cast<int>(ticks));
+	return true;
+}
+
+void Game::Simulate()
+{
+	using Clock = std::chrono::steady_clock;
+
+	const Clock::duration tick_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(constants::tick_seconds));
+	Clock::time_point next_tick = Clock::now();
+	Clock::time_point next_dump = next_tick + std::chrono::seconds(1);
+
+	int publishes = 0;
+	int ticks = 0;
+
+	if (gpu_context_ != nullptr)
+	{
+		SDL_GL_MakeCurrent(gpu_window_, gpu_context_);
+	}
+
+	while (simulating_)
+	{
+		// Catch up on every tick that is due, then publish once, so a slow
+		// tick delays the next state instead of the frames drawn meanwhile.
+		while (Clock::now() >= next_tick)
+		{
+			sim_profiler_.BeginFrame();
+
+			{
+				const Profiler::Scope scope(sim_profiler_, Phase::tick);
+				Tick();
+			}
+
+			sim_profiler_.EndFrame();
+			tick_time_ = next_tick;
+			next_tick += tick_period;
+			++ticks;
+		}
+
+		PublishState();
+		++publishes;
+
+		if (Clock::now() >= next_dump)
+		{
+			next_dump += std::chrono::seconds(1);
+			sim_profiler_.Dump(publishes, ticks);
+			publishes = 0;
+			ticks = 0;
+		}
+
+		std::this_thread::sleep_until(next_tick);
+	}
+
+	if (gpu_context_ != nullptr)
+	{
+		SDL_GL_MakeCurrent(gpu_window_, nullptr);
+	}
+}
+
+void Game::HandleEvents()
+{
+	SDL_Event e;
+
+	// Motion only records where the mouse is; the mouse box and any wall
+	// stroke follow once per frame, from wherever the events left it.
+	bool mouse_moved = false;
+
+	while (SDL_PollEvent(&e) != 0)
+	{
+		if (e.type == SDL_QUIT)
+		{
+			running_ = false;
+			return;
+		}
+		else if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET)
+		{
+			static_layer_valid_ = false;
+		}
+		else if (e.type == SDL_MOUSEBUTTONDOWN)
+		{
+			mouse_position_ = { e.button.x, e.button.y };
+
+			if (e.button.button == SDL_BUTTON_LEFT)
+			{
+				controls_.mouse_left_pressed_ = true;
+			}
+			else if (e.button.button == SDL_BUTTON_MIDDLE)
+			{
+				mouse_middle_pressed_ = true;
+			}
+			else if (e.button.button == SDL_BUTTON_RIGHT)
+			{
+				mouse_right_pressed_ = true;
+				const Vector2d<float> world = ToWorld(mouse_position_);
+				setting_walls_ = !static_grid_.IsWall(static_cast<int>(std::floor(world.x / cell_size_)), static_cast<int>(std::floor(world.y / cell_size_)));
+				ExtendStroke(mouse_position_, true);
+			}
+		}
+		else if (e.type == SDL_MOUSEBUTTONUP)
+		{
+			mouse_position_ = { e.button.x, e.button.y };
+
+			if (e.button.button == SDL_BUTTON_LEFT)
+			{
+				controls_.mouse_left_pressed_ = false;
+			}
+			else if (e.button.button == SDL_BUTTON_MIDDLE)
+			{
+				mouse_middle_pressed_ = false;
+			}
+			else if (e.button.button == SDL_BUTTON_RIGHT && mouse_right_pressed_)
+			{
+				ExtendStroke(mouse_position_, false);
+				mouse_right_pressed_ = false;
+			}
+		}
+		
+		if (e.type == SDL_MOUSEMOTION)
+		{
+			mouse_position_ = { e.motion.x, e.motion.y };
+			mouse_moved = true;
+
+			if (mouse_middle_pressed_)
+			{
+				camera_.position_.x -= e.motion.xrel / camera_.zoom_;
+				camera_.position_.y -= e.motion.yrel / camera_.zoom_;
+			}
+		}
+
+		if (e.type == SDL_MOUSEWHEEL && (SDL_GetModState() & KMOD_CTRL) != 0)
+		{
+			Zoom(std::pow(1.25f, static_cast<float>(e.wheel.y)), mouse_position_);
+			MoveMouseBox();
+		}
+		else if (e.type == SDL_MOUSEWHEEL)
+		{
+			constexpr float spread_step = constants::pi / 36.0f;
+			controls_.fan_spread_ = std::clamp(controls_.fan_spread_ + static_cast<float>(e.wheel.y) * spread_step, spread_step, 2.0f * constants::pi);
+		}
+
+		int speed = 5;
+
+		if (e.type == SDL_KEYDOWN)
+		{
+			if (e.key.keysym.sym == SDLK_F3)
+			{
+				show_profile_ = !show_profile_;
+			}
+
+			if (e.key.keysym.sym == SDLK_v)
+			{
+				const PacingMode mode = pacer_.GetMode();
+				SetFramePacing(mode == PacingMode::vsync ? PacingMode::capped : (mode == PacingMode::capped ? PacingMode::uncapped : PacingMode::vsync), 60);
+				printf("Frame pacing: %s\n", GetPacingModeName(pacer_.GetMode()));
+			}
+
+			if (e.key.keysym.sym == SDLK_F5)
+			{
+				SaveMap(map_path_.c_str());
+			}
+
+			const float pan = 64.0f / camera_.zoom_;
+
+			if (e.key.keysym.sym == SDLK_LEFT || e.key.keysym.sym == SDLK_RIGHT || e.key.keysym.sym == SDLK_UP || e.key.keysym.sym == SDLK_DOWN)
+			{
+				camera_.position_.x += e.key.keysym.sym == SDLK_LEFT ? -pan : (e.key.keysym.sym == SDLK_RIGHT ? pan : 0.0f);
+				camera_.position_.y += e.key.keysym.sym == SDLK_UP ? -pan : (e.key.keysym.sym == SDLK_DOWN ? pan : 0.0f);
+				MoveMouseBox();
+			}
+
+			if (e.key.keysym.sym == SDLK_HOME)
+			{
+				camera_ = { { 0.0f, 0.0f }, 1.0f };
+				MoveMouseBox();
+			}
+
+			if (e.key.keysym.sym == SDLK_f)
+			{
+				controls_.fan_mode_ = controls_.fan_mode_ == FanMode::off ? FanMode::fan : (controls_.fan_mode_ == FanMode::fan ? FanMode::corners : FanMode::off);
+			}
+
+			if (e.key.keysym.sym == SDLK_w)
+			{
+				controls_.vy_ = -speed;
+			}
+
+			if (e.key.keysym.sym == SDLK_a)
+			{
+				controls_.vx_ = -speed;
+			}
+
+			if (e.key.keysym.sym == SDLK_s)
+			{
+				controls_.vy_ = speed;
+			}
+
+			if (e.key.keysym.sym == SDLK_d)
+			{
+				controls_.vx_ = speed;
+			}
+		}
+		else if (e.type == SDL_KEYUP)
+		{
+			if (e.key.keysym.sym == SDLK_w)
+			{
+				controls_.vy_ = 0;
+			}
+
+			if (e.key.keysym.sym == SDLK_a)
+			{
+				controls_.vx_ = 0;
+			}
+
+			if (e.key.keysym.sym == SDLK_s)
+			{
+				controls_.vy_ = 0;
+			}
+
+			if (e.key.keysym.sym == SDLK_d)
+			{
+				controls_.vx_ = 0;
+			}
+		}
+	}
+
+	if (mouse_moved)
+	{
+		MoveMouseBox();
+
+		if (mouse_right_pressed_)
+		{
+			ExtendStroke(mouse_position_, false);
+		}
+	}
+}
+
+void Game::SubmitInput()
+{
+	const std::lock_guard<std::mutex> lock(input_mutex_);
+
+	shared_controls_ = controls_;
+	shared_wall_edits_.insert(shared_wall_edits_.end(), wall_edits_.begin(), wall_edits_.end());
+	wall_edits_.clear();
+}
+
+void Game::Tick()
+{
+	{
+		const std::lock_guard<std::mutex> lock(input_mutex_);
+
+		sim_controls_ = shared_controls_;
+		sim_wall_edits_.swap(shared_wall_edits_);
+	}
+
+	recorder_.Write(sim_controls_, sim_wall_edits_);
+
+	const std::uint64_t walls_version = walls_version_;
+
+	for (const WallEdit& edit : sim_wall_edits_)
+	{
+		if (grid_.GetView().Contains(edit.x_, edit.y_) && grid_.IsWall(edit.x_, edit.y_) != edit.wall_)
+		{
+			grid_.SetWall(edit.x_, edit.y_, edit.wall_);
+			++walls_version_;
+		}
+	}
+
+	// Before anything casts: rays jumping by a stale field would pass
+	// through the new walls. The dirty region is cleared on publishing, so
+	// ticks between publishes redo each other's tiles.
+	if (walls_version_ != walls_version)
+	{
+		distance_field_.Update(grid_.GetView(), grid_.GetDirtyRegion());
+	}
+
+	sim_wall_edits_.clear();
+	hit_marks_->Clear();
+
+	previous_player_ = player_;
+	player_.vx_ = sim_controls_.vx_;
+	player_.vy_ = sim_controls_.vy_;
+	player_.box_.x += player_.vx_;
+	player_.box_.y += player_.vy_;
+
+	if (sim_controls_.mouse_left_pressed_)
+	{
+		DigitalDifferentialAnalysis();
+	}
+	else
+	{
+		dda_intersection_ = { -1.0, -1.0 };
+	}
+
+	if (sim_controls_.fan_mode_ != FanMode::off)
+	{
+		CastVisibility();
+	}
+
+	if (agents_.GetCount() > 0)
+	{
+		TickAgents();
+	}
+}
+
+void Game::TickAgents()
+{
+	const Profiler::Scope scope(GetSimulationProfiler(), Phase::agents);
+	const float max_distance = std::max(cells_width_, cells_height_) * cell_size_ * 10.0f;
+
+	if (gpu_caster_ != nullptr && gpu_walls_version_ != walls_version_)
+	{
+		gpu_caster_->SetGrid(grid_.GetView());
+		gpu_walls_version_ = walls_version_;
+	}
+
+	// Agents roam the open parts of the map, where the field's jumps are longest.
+	agents_.Tick(distance_field_.Attach(grid_.GetView()), *agent_pool_, max_distance, dda::Kernel::distance_field, gpu_caster_.get(), hit_marks_.get());
+}
+
+void Game::DigitalDifferentialAnalysis()
+{
+	Profiler& profiler = GetSimulationProfiler();
+	const Profiler::Scope scope(profiler, Phase::dda);
+
+	const SDL_Rect& mouse_box = sim_controls_.mouse_box_;
+	Vector2d<float> player_pos = { static_cast<float>(player_.box_.x + (player_.box_.w / 2)), static_cast<float>(player_.box_.y + (player_.box_.h / 2)) };
+	Vector2d<float> mouse_pos = { static_cast<float>(mouse_box.x + (mouse_box.w / 2)), static_cast<float>(mouse_box.y + (mouse_box.h / 2)) };
+
+	if (mouse_pos.x < 0 || mouse_pos.x > cells_width_ * cell_size_ || mouse_pos.y < 0 || mouse_pos.y > cells_height_ * cell_size_)
+	{
+		return;
+	}
+
+	const Vector2d<float> ray_dir = { mouse_pos.x - player_pos.x, mouse_pos.y - player_pos.y };
+	const float max_distance = std::max(cells_width_, cells_height_) * cell_size_ * 10.0f;
+
+	const dda::RayCaster ray_caster(grid_.GetView());
+	dda::RayStats stats = { 0, 0 };
+	const dda::RayHit hit = ray_caster.Cast(player_pos, ray_dir, max_distance, stats);
+	profiler.AddRay(stats);
+
+	if (hit.hit_)
+	{
+		hit_marks_->Mark(hit.cell_.x, hit.cell_.y);
+		dda_intersection_ = { hit.point_.x, hit.point_.y };
+	}
+	else
+	{
+		dda_intersection_ = { -1.0, -1.0 };
+	}
+}
+
+void Game::CastVisibility()
+{
+	const Profiler::Scope scope(GetSimulationProfiler(), Phase::dda);
+
+	const SDL_Rect& mouse_box = sim_controls_.mouse_box_;
+	const Vector2d<float> player_pos = { static_cast<float>(player_.box_.x + (player_.box_.w / 2)), static_cast<float>(player_.box_.y + (player_.box_.h / 2)) };
+	const Vector2d<float> mouse_pos = { static_cast<float>(mouse_box.x + (mouse_box.w / 2)), static_cast<float>(mouse_box.y + (mouse_box.h / 2)) };
+	const float angle = std::atan2(mouse_pos.y - player_pos.y, mouse_pos.x - player_pos.x);
+	const float max_distance = std::max(cells_width_, cells_height_) * cell_size_ * 10.0f;
+
+	if (sim_controls_.fan_mode_ == FanMode::fan)
+	{
+		dda::CastFan(grid_.GetView(), player_pos, angle, sim_controls_.fan_spread_, fan_ray_count_, max_distance, visibility_);
+	}
+	else
+	{
+		dda::CastCorners(grid_.GetView(), player_pos, angle, sim_controls_.fan_spread_, max_distance, visibility_);
+	}
+}
+
+void Game::PublishState()
+{
+	FrameState& state = states_.GetWriteSlot();
+
+	state.tick_time_ = tick_time_;
+	state.previous_player_ = previous_player_;
+	state.player_ = player_;
+	state.mouse_box_ = sim_controls_.mouse_box_;
+	state.render_line_ = sim_controls_.mouse_left_pressed_;
+	state.dda_intersection_ = dda_intersection_;
+	state.fan_mode_ = sim_controls_.fan_mode_;
+	state.visibility_ = visibility_;
+	state.hits_.assign(hit_marks_->GetCells().begin(), hit_marks_->GetCells().end());
+	state.agents_ = agents_.GetPositions();
+	state.agent_hits_.clear();
+
+	for (const dda::RayHit& hit : agents_.GetHits())
+	{
+		if (hit.hit_)
+		{
+			state.agent_hits_.push_back(hit.point_);
+		}
+	}
+
+	// Copying the walls would outweigh the rest of the state on large
+	// maps, so a state carries just the tiles changed since the walls the
+	// main thread last drew. Those it has drawn are dropped from the log;
+	// a version it read late only keeps a few more.
+	const dda::DirtyRegion& dirty = grid_.GetDirtyRegion();
+
+	if (dirty.IsAll())
+	{
+		for (int y = 0; y < dirty.GetTilesHeight(); ++y)
+		{
+			for (int x = 0; x < dirty.GetTilesWidth(); ++x)
+			{
+				wall_changes_.push_back({ { x, y }, walls_version_ });
+			}
+		}
+	}
+	else
+	{
+		for (const Vector2d<int>& tile : dirty.GetTiles())
+		{
+			wall_changes_.push_back({ tile, walls_version_ });
+		}
+	}
+
+	const std::uint64_t drawn_version = static_walls_version_.load(std::memory_order_relaxed);
+	wall_changes_.erase(wall_changes_.begin(), std::find_if(wall_changes_.begin(), wall_changes_.end(), [drawn_version](const WallTileChange& change) { return change.walls_version_ > drawn_version; }));
+
+	constexpr int tile_size = 1 << dda::DirtyRegion::tile_shift;
+	const dda::GridView walls = grid_.GetView();
+
+	state.wall_tiles_.clear();
+	state.wall_rows_.clear();
+
+	for (const WallTileChange& change : wall_changes_)
+	{
+		const int tile_x = change.tile_.x * tile_size;
+		const std::uint64_t mask = ((std::uint64_t{ 1 } << tile_size) - 1) << (tile_x & 63);
+
+		state.wall_tiles_.push_back(change.tile_);
+
+		for (int y = change.tile_.y * tile_size; y < (change.tile_.y + 1) * tile_size; ++y)
+		{
+			state.wall_rows_.push_back(y < walls.height_ ? walls.words_[static_cast<std::size_t>(y) * walls.words_per_row_ + (tile_x >> 6)] & mask : 0);
+		}
+	}
+
+	state.walls_version_ = walls_version_;
+	state.dirty_since_version_ = drawn_version;
+
+	states_.Publish();
+	grid_.ClearDirtyRegion();
+}
+
+void Game::Render(const FrameState& state)
+{
+	const SDL_Rect visible_cells = GetVisibleCells();
+
+	UpdateStaticGrid(state);
+	RenderStaticLayer();
+	static_grid_.ClearDirtyRegion();
+
+	SDL_RenderSetViewport(renderer_, NULL);
+	SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0x00, 0xff);
+	SDL_RenderClear(renderer_);
+
+	if (static_layer_ != nullptr)
+	{
+		SDL_RenderCopy(renderer_, static_layer_, NULL, NULL);
+	}
+	else
+	{
+		RenderGrid(visible_cells);
+		RenderCells(visible_cells);
+	}
+
+	RenderHits(state);
+
+	if (state.fan_mode_ != FanMode::off)
+	{
+		RenderVisibility(state);
+	}
+
+	RenderAgents(state);
+
+	const SDL_FPoint& dda_intersection = state.dda_intersection_;
+
+	if (dda_intersection.x != -1.0f && dda_intersection.y != -1.0f)
+	{
+		constexpr float box_size = 10.0f;
+		const SDL_FPoint intersection = ToScreen(dda_intersection.x, dda_intersection.y);
+		const SDL_FRect collision_box = { intersection.x - (box_size / 2), intersection.y - (box_size / 2), box_size, box_size };
+		SDL_SetRenderDrawColor(renderer_, 0xff, 0xff, 0xff, 0xff);
+		SDL_RenderDrawRectF(renderer_, &collision_box);
+	}
+
+	const std::chrono::duration<float> since_tick = std::chrono::steady_clock::now() - state.tick_time_;
+	const float alpha = std::clamp(since_tick.count() / static_cast<float>(constants::tick_seconds), 0.0f, 1.0f);
+
+	const SDL_Rect& previous = state.previous_player_.box_;
+	const SDL_Rect& current = state.player_.box_;
+	const SDL_FPoint player_position = ToScreen(previous.x + (current.x - previous.x) * alpha, previous.y + (current.y - previous.y) * alpha);
+	const SDL_FRect player_box = { player_position.x, player_position.y, current.w * camera_.zoom_, current.h * camera_.zoom_ };
+	const SDL_FPoint mouse_position = ToScreen(static_cast<float>(state.mouse_box_.x), static_cast<float>(state.mouse_box_.y));
+	const SDL_FRect mouse_box = { mouse_position.x, mouse_position.y, state.mouse_box_.w * camera_.zoom_, state.mouse_box_.h * camera_.zoom_ };
+
+	SDL_SetRenderDrawColor(renderer_, 0xff, 0x00, 0x00, 0xff);
+	SDL_RenderFillRectF(renderer_, &player_box);
+
+	SDL_SetRenderDrawColor(renderer_, 0x00, 0xff, 0x00, 0xff);
+	SDL_RenderFillRectF(renderer_, &mouse_box);
+
+	if (state.render_line_)
+	{
+		SDL_SetRenderDrawColor(renderer_, 0x00, 0xff, 0xff, 0xff);
+		SDL_RenderDrawLineF(renderer_, player_box.x + (player_box.w / 2), player_box.y + (player_box.h / 2), mouse_box.x + (mouse_box.w / 2), mouse_box.y + (mouse_box.h / 2));
+	}
+
+	if (show_profile_)
+	{
+		RenderProfileOverlay();
+	}
+
+	SDL_RenderPresent(renderer_);
+}
+
+void Game::UpdateStaticGrid(const FrameState& state)
+{
+	if (state.walls_version_ == static_walls_version_.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+
+	constexpr int tile_size = 1 << dda::DirtyRegion::tile_shift;
+	const dda::GridView drawn = static_grid_.GetView();
+	const std::uint64_t* row = state.wall_rows_.data();
+
+	for (const Vector2d<int>& tile : state.wall_tiles_)
+	{
+		const int tile_x = tile.x * tile_size;
+		const std::uint64_t mask = ((std::uint64_t{ 1 } << tile_size) - 1) << (tile_x & 63);
+
+		for (int y = tile.y * tile_size; y < (tile.y + 1) * tile_size; ++y, ++row)
+		{
+			if (y >= drawn.height_)
+			{
+				continue;
+			}
+
+			std::uint64_t changed = (drawn.words_[static_cast<std::size_t>(y) * drawn.words_per_row_ + (tile_x >> 6)] & mask) ^ *row;
+
+			while (changed != 0)
+			{
+				const int bit = __builtin_ctzll(changed);
+				static_grid_.SetWall((tile_x & ~63) + bit, y, ((*row >> bit) & 1) != 0);
+				changed &= changed - 1;
+			}
+		}
+	}
+
+	// Only the version is shared: the simulation drops the changes it
+	// covers from the states it publishes after reading it.
+	static_walls_version_.store(state.walls_version_, std::memory_order_relaxed);
+}
+
+void Game::RenderStaticLayer()
+{
+	const dda::DirtyRegion& dirty = static_grid_.GetDirtyRegion();
+	const bool camera_moved = camera_.position_.x != static_camera_.position_.x || camera_.position_.y != static_camera_.position_.y || camera_.zoom_ != static_camera_.zoom_;
+
+	if (static_layer_ == nullptr || (static_layer_valid_ && dirty.IsEmpty() && !camera_moved))
+	{
+		return;
+	}
+
+	SDL_SetRenderTarget(renderer_, static_layer_);
+
+	const SDL_Rect visible_cells = GetVisibleCells();
+
+	// The layer holds the view rather than the map, so moving the camera
+	// redraws it whole; the cost follows the window size, not the map's.
+	if (!static_layer_valid_ || dirty.IsAll() || camera_moved)
+	{
+		SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0x00, 0xff);
+		SDL_RenderClear(renderer_);
+		RenderGrid(visible_cells);
+		RenderCells(visible_cells);
+		static_layer_valid_ = true;
+		static_camera_ = camera_;
+	}
+	else
+	{
+		constexpr int tile_cells = 1 << dda::DirtyRegion::tile_shift;
+
+		for (const Vector2d<int>& tile : dirty.GetTiles())
+		{
+			const SDL_Rect tile_rect = { tile.x * tile_cells, tile.y * tile_cells, tile_cells, tile_cells };
+			SDL_Rect cells;
+
+			if (!SDL_IntersectRect(&tile_rect, &visible_cells, &cells))
+			{
+				continue;
+			}
+
+			const SDL_Rect pixels = GetScreenRect(cells);
+
+			SDL_RenderSetClipRect(renderer_, &pixels);
+			SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0x00, 0xff);
+			SDL_RenderFillRect(renderer_, &pixels);
+			RenderGrid(cells);
+			RenderCells(cells);
+		}
+
+		SDL_RenderSetClipRect(renderer_, NULL);
+	}
+
+	SDL_SetRenderTarget(renderer_, NULL);
+}
+
+void Game::RenderGrid(const SDL_Rect& cells)
+{
+	// Lines closer than this would only tint the whole view grey.
+	constexpr float min_spacing = 8.0f;
+
+	if (cell_size_ * camera_.zoom_ < min_spacing)
+	{
+		return;
+	}
+
+	const SDL_Rect pixels = GetScreenRect(cells);
+
+	// One-pixel rects draw the same pixels as axis-aligned lines and can be
+	// submitted together, unlike SDL_RenderDrawLines which joins its points.
+	line_rects_.clear();
+
+	for (int y = std::max(cells.y, 1); y < std::min(cells.y + cells.h + 1, cells_height_); ++y)
+	{
+		line_rects_.push_back({ pixels.x, GetScreenRect({ cells.x, y, 0, 0 }).y, pixels.w + 1, 1 });
+	}
+
+	for (int x = std::max(cells.x, 1); x < std::min(cells.x + cells.w + 1, cells_width_); ++x)
+	{
+		line_rects_.push_back({ GetScreenRect({ x, cells.y, 0, 0 }).x, pixels.y, 1, pixels.h + 1 });
+	}
+
+	SDL_SetRenderDrawColor(renderer_, 0x14, 0x14, 0x14, 0xff);
+	SDL_RenderFillRects(renderer_, line_rects_.data(), static_cast<int>(line_rects_.size()));
+}
+
+void Game::RenderCells(const SDL_Rect& cells)
+{
+	const int shift = GetDetailShift();
+
+	if (shift != 0)
+	{
+		RenderBlocks(cells, shift);
+		return;
+	}
+
+	wall_rects_.clear();
+
+	for (int y = cells.y; y < cells.y + cells.h; ++y)
+	{
+		for (int x = cells.x; x < cells.x + cells.w; ++x)
+		{
+			if (static_grid_.IsWall(x, y))
+			{
+				wall_rects_.push_back(GetScreenRect({ x, y, 1, 1 }));
+			}
+		}
+	}
+
+	SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0xff, 0xff);
+	SDL_RenderFillRects(renderer_, wall_rects_.data(), static_cast<int>(wall_rects_.size()));
+}
+
+void Game::RenderBlocks(const SDL_Rect& cells, int shift)
+{
+	if (cells.w <= 0 || cells.h <= 0)
+	{
+		return;
+	}
+
+	const dda::GridView walls = static_grid_.GetView();
+	const int block_cells = 1 << shift;
+	const int blocks_per_row = dda::BlocksPerSide(walls.width_, shift);
+	const int shades = static_cast<int>(block_rects_.size());
+
+	for (std::vector<SDL_Rect>& rects : block_rects_)
+	{
+		rects.clear();
+	}
+
+	for (int by = cells.y >> shift; by <= (cells.y + cells.h - 1) >> shift; ++by)
+	{
+		for (int bx = cells.x >> shift; bx <= (cells.x + cells.w - 1) >> shift; ++bx)
+		{
+			const std::size_t index = static_cast<std::size_t>(by) * blocks_per_row + bx;
+			const int count = shift == dda::fine_block_shift ? walls.fine_blocks_[index] : walls.coarse_blocks_[index];
+
+			if (count == 0)
+			{
+				continue;
+			}
+
+			const int area = std::min(block_cells, walls.width_ - (bx << shift)) * std::min(block_cells, walls.height_ - (by << shift));
+			block_rects_[std::min((count * shades - 1) / area, shades - 1)].push_back(GetScreenRect({ bx << shift, by << shift, block_cells, block_cells }));
+		}
+	}
+
+	for (int shade = 0; shade < shades; ++shade)
+	{
+		SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, static_cast<Uint8>(0xff * (shade + 1) / shades), 0xff);
+		SDL_RenderFillRects(renderer_, block_rects_[shade].data(), static_cast<int>(block_rects_[shade].size()));
+	}
+}
+
+void Game::RenderHits(const FrameState& state)
+{
+	wall_rects_.clear();
+
+	for (const Vector2d<int>& cell : state.hits_)
+	{
+		wall_rects_.push_back(GetScreenRect({ cell.x, cell.y, 1, 1 }));
+	}
+
+	SDL_SetRenderDrawColor(renderer_, 0x80, 0x80, 0xff, 0xff);
+	SDL_RenderFillRects(renderer_, wall_rects_.data(), static_cast<int>(wall_rects_.size()));
+}
+
+void Game::RenderVisibility(const FrameState& state)
+{
+	const dda::VisibilityPolygon& visibility = state.visibility_;
+	const std::vector<Vector2d<float>>& points = visibility.points_;
+
+	if (points.size() < 2)
+	{
+		return;
+	}
+
+	// One triangle fan around the origin, vertex 0, submitted as an
+	// indexed triangle list in a single SDL_RenderGeometry call.
+	constexpr SDL_Color color = { 0xff, 0xff, 0x80, 0x60 };
+
+	fan_vertices_.clear();
+	fan_vertices_.push_back({ ToScreen(visibility.origin_.x, visibility.origin_.y), color, { 0.0f, 0.0f } });
+
+	for (const Vector2d<float>& point : points)
+	{
+		fan_vertices_.push_back({ ToScreen(point.x, point.y), color, { 0.0f, 0.0f } });
+	}
+
+	const int count = static_cast<int>(points.size());
+	const int triangles = visibility.closed_ ? count : count - 1;
+
+	fan_indices_.clear();
+
+	for (int i = 0; i < triangles; ++i)
+	{
+		fan_indices_.push_back(0);
+		fan_indices_.push_back(1 + i);
+		fan_indices_.push_back(1 + (i + 1) % count);
+	}
+
+	SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
+	SDL_RenderGeometry(renderer_, NULL, fan_vertices_.data(), static_cast<int>(fan_vertices_.size()), fan_indices_.data(), static_cast<int>(fan_indices_.size()));
+	SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_NONE);
+}
+
+void Game::RenderAgents(const FrameState& state)
+{
+	if (state.agents_.empty())
+	{
+		return;
+	}
+
+	constexpr SDL_Color agent_color = { 0xff, 0x80, 0x00, 0xff };
+	constexpr SDL_Color hit_color = { 0xff, 0xff, 0xff, 0xff };
+
+	agent_vertices_.clear();
+	agent_indices_.clear();
+
+	// Points off screen are dropped here, so the batch grows with the
+	// agents in view rather than with the crowd.
+	const auto add_quad = [&](const Vector2d<float>& point, float size, const SDL_Color& color)
+	{
+		const SDL_FPoint center = ToScreen(point.x, point.y);
+		const float half = size / 2.0f;
+
+		if (center.x < -half || center.y < -half || center.x > constants::screen_width + half || center.y > constants::screen_height + half)
+		{
+			return;
+		}
+
+		const int first = static_cast<int>(agent_vertices_.size());
+		agent_vertices_.push_back({ { center.x - half, center.y - half }, color, { 0.0f, 0.0f } });
+		agent_vertices_.push_back({ { center.x + half, center.y - half }, color, { 0.0f, 0.0f } });
+		agent_vertices_.push_back({ { center.x + half, center.y + half }, color, { 0.0f, 0.0f } });
+		agent_vertices_.push_back({ { center.x - half, center.y + half }, color, { 0.0f, 0.0f } });
+
+		for (const int corner : { 0, 1, 2, 0, 2, 3 })
+		{
+			agent_indices_.push_back(first + corner);
+		}
+	};
+
+	const float agent_size = std::max(4.0f * camera_.zoom_, 2.0f);
+
+	for (const Vector2d<float>& hit : state.agent_hits_)
+	{
+		add_quad(hit, 2.0f, hit_color);
+	}
+
+	for (const Vector2d<float>& agent : state.agents_)
+	{
+		add_quad(agent, agent_size, agent_color);
+	}
+
+	SDL_RenderGeometry(renderer_, NULL, agent_vertices_.data(), static_cast<int>(agent_vertices_.size()), agent_indices_.data(), static_cast<int>(agent_indices_.size()));
+}
+
+void Game::RenderProfileOverlay()
+{
+	// Stacked bar per frame, newest on the right: events, tick without the
+	// DDA and agents, DDA, agents, render and unaccounted time, over a line
+	// at 60 fps.
+	constexpr int bar_width = 2;
+	constexpr int pixels_per_ms = 4;
+	constexpr int graph_height = 40 * pixels_per_ms;
+	constexpr int graph_width = Profiler::history_size * bar_width;
+	constexpr int part_count = 6;
+	constexpr SDL_Color colors[part_count] = { { 0xff, 0xff, 0x00, 0xff }, { 0xff, 0x00, 0xff, 0xff }, { 0x00, 0xff, 0xff, 0xff }, { 0x00, 0xff, 0x00, 0xff }, { 0xff, 0x80, 0x00, 0xff }, { 0x80, 0x80, 0x80, 0xff } };
+
+	const int left = 8;
+	const int bottom = constants::screen_height - 8;
+	const SDL_Rect background = { left, bottom - graph_height, graph_width, graph_height };
+
+	SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(renderer_, 0x00, 0x00, 0x00, 0xc0);
+	SDL_RenderFillRect(renderer_, &background);
+	SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_NONE);
+
+	for (int part = 0; part < part_count; ++part)
+	{
+		profile_rects_.clear();
+
+		for (int age = 0; age < Profiler::history_size; ++age)
+		{
+			const Profiler::FrameTimes& frame = profiler_.GetFrame(age);
+			const std::int64_t events = frame[static_cast<int>(Phase::handle_events)];
+			const std::int64_t dda = frame[static_cast<int>(Phase::dda)];
+			const std::int64_t agents = frame[static_cast<int>(Phase::agents)];
+			const std::int64_t tick = std::max<std::int64_t>(frame[static_cast<int>(Phase::tick)] - dda - agents, 0);
+			const std::int64_t render = frame[static_cast<int>(Phase::render)];
+			const std::int64_t other = std::max<std::int64_t>(frame[static_cast<int>(Phase::frame)] - events - tick - dda - agents - render, 0);
+			const std::int64_t parts[part_count] = { events, tick, dda, agents, render, other };
+
+			std::int64_t below = 0;
+
+			for (int i = 0; i < part; ++i)
+			{
+				below += parts[i];
+			}
+
+			const int y0 = static_cast<int>(std::min<std::int64_t>(below * pixels_per_ms / 1000000, graph_height));
+			const int y1 = static_cast<int>(std::min<std::int64_t>((below + parts[part]) * pixels_per_ms / 1000000, graph_height));
+
+			if (y1 > y0)
+			{
+				profile_rects_.push_back({ left + graph_width - (age + 1) * bar_width, bottom - y1, bar_width, y1 - y0 });
+			}
+		}
+
+		SDL_SetRenderDrawColor(renderer_, colors[part].r, colors[part].g, colors[part].b, colors[part].a);
+		SDL_RenderFillRects(renderer_, profile_rects_.data(), static_cast<int>(profile_rects_.size()));
+	}
+
+	const int budget = bottom - 1000 * pixels_per_ms / 60;
+	SDL_SetRenderDrawColor(renderer_, 0xff, 0xff, 0xff, 0xff);
+	SDL_RenderDrawLine(renderer_, left, budget, left + graph_width - 1, budget);
 }
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const char* GetPhaseName(Phase phase)
+{
+	switch (phase)
+	{
+		case Phase::handle_events:
+			return "handle_events";
+		case Phase::tick:
+			return "tick";
+		case Phase::dda:
+			return "dda";
+		case Phase::agents:
+			return "agents";
+		case Phase::render:
+			return "render";
+		case Phase::frame:
+			return "frame";
+		default:
+			return "unknown";
+	}
+}
+
+Histogram::Histogram()
+{
+	Clear();
+}
+
+int Histogram::GetBucket(std::uint64_t value)
+{
+	if (value < sub_buckets)
+	{
+		return static_cast<int>(value);
+	}
+
+	int msb = 63;
+
+	while ((value >> msb) == 0)
+	{
+		--msb;
+	}
+
+	const int sub_bucket = static_cast<int>((value >> (msb - sub_bucket_bits)) & (sub_buckets - 1));
+	return (msb - sub_bucket_bits + 1) * sub_buckets + sub_bucket;
+}
+
+std::uint64_t Histogram::GetBucketUpperBound(int bucket)
+{
+	if (bucket < sub_buckets)
+	{
+		return static_cast<std::uint64_t>(bucket);
+	}
+
+	const int shift = bucket / sub_buckets - 1;
+	const std::uint64_t lower = static_cast<std::uint64_t>(sub_buckets + bucket % sub_buckets) << shift;
+	return lower + ((std::uint64_t{ 1 } << shift) - 1);
+}
+
+void Histogram::Add(std::uint64_t value)
+{
+	++counts_[GetBucket(value)];
+	++count_;
+	max_ = std::max(max_, value);
+}
+
+void Histogram::Clear()
+{
+	counts_.fill(0);
+	count_ = 0;
+	max_ = 0;
+}
+
+std::uint64_t Histogram::GetCount() const
+{
+	return count_;
+}
+
+std::uint64_t Histogram::GetMax() const
+{
+	return max_;
+}
+
+std::uint64_t Histogram::GetPercentile(double percentile) const
+{
+	if (count_ == 0)
+	{
+		return 0;
+	}
+
+	const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count_))));
+	std::uint64_t seen = 0;
+
+	for (int bucket = 0; bucket < bucket_count; ++bucket)
+	{
+		seen += counts_[bucket];
+
+		if (seen >= rank)
+		{
+			return std::min(GetBucketUpperBound(bucket), max_);
+		}
+	}
+
+	return max_;
+}
+
+Profiler::Scope::Scope(Profiler& profiler, Phase phase) : profiler_(profiler), phase_(phase), start_(Clock::now())
+{
+}
+
+Profiler::Scope::~Scope()
+{
+	profiler_.Add(phase_, Clock::now() - start_);
+}
+
+Profiler::Profiler() : 
+	history_next_(0), 
+	frame_start_(Clock::now()), 
+	interval_start_(frame_start_), 
+	dump_(nullptr), 
+	dump_json_(false)
+{
+	for (FrameTimes& frame : history_)
+	{
+		frame.fill(0);
+	}
+
+	current_.fill(0);
+}
+
+Profiler::~Profiler()
+{
+	if (dump_ != nullptr)
+	{
+		std::fclose(dump_);
+	}
+}
+
+Profiler::Scope Profiler::Measure(Phase phase)
+{
+	return Scope(*this, phase);
+}
+
+void Profiler::Add(Phase phase, Clock::duration duration)
+{
+	current_[static_cast<int>(phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+void Profiler::AddRay(const dda::RayStats& stats)
+{
+	steps_.Add(stats.steps_);
+	skips_.Add(stats.skips_);
+}
+
+void Profiler::BeginFrame()
+{
+	current_.fill(0);
+	frame_start_ = Clock::now();
+}
+
+void Profiler::EndFrame()
+{
+	Add(Phase::frame, Clock::now() - frame_start_);
+
+	for (int phase = 0; phase < static_cast<int>(Phase::count); ++phase)
+	{
+		phases_[phase].Add(static_cast<std::uint64_t>(current_[phase]));
+	}
+
+	history_[history_next_] = current_;
+	history_next_ = (history_next_ + 1) % history_size;
+}
+
+const Profiler::FrameTimes& Profiler::GetFrame(int age) const
+{
+	return history_[(history_next_ - 1 - age % history_size + 2 * history_size) % history_size];
+}
+
+const Histogram& Profiler::GetHistogram(Phase phase) const
+{
+	return phases_[static_cast<int>(phase)];
+}
+
+const Histogram& Profiler::GetStepHistogram() const
+{
+	return steps_;
+}
+
+bool Profiler::OpenDump(const char* path)
+{
+	if (dump_ != nullptr)
+	{
+		std::fclose(dump_);
+	}
+
+	dump_ = std::fopen(path, "w");
+
+	if (dump_ == nullptr)
+	{
+		return false;
+	}
+
+	const std::size_t length = std::strlen(path);
+	dump_json_ = length >= 5 && std::strcmp(path + length - 5, ".json") == 0;
+
+	if (!dump_json_)
+	{
+		std::fprintf(dump_, "seconds,frames,ticks");
+
+		for (int phase = 0; phase < static_cast<int>(Phase::count); ++phase)
+		{
+			const char* name = GetPhaseName(static_cast<Phase>(phase));
+			std::fprintf(dump_, ",%s_p50_us,%s_p99_us,%s_max_us", name, name, name);
+		}
+
+		std::fprintf(dump_, ",rays,steps_p50,steps_p99,steps_max,skips_p50,skips_p99,skips_max\n");
+	}
+
+	return true;
+}
+
+void Profiler::Dump(int frames, int ticks)
+{
+	const Clock::time_point now = Clock::now();
+
+	if (dump_ != nullptr)
+	{
+		const double seconds = std::chrono::duration<double>(now - interval_start_).count();
+
+		if (dump_json_)
+		{
+			std::fprintf(dump_, "{\"seconds\":%.6f,\"frames\":%d,\"ticks\":%d", seconds, frames, ticks);
+
+			for (int phase = 0; phase < static_cast<int>(Phase::count); ++phase)
+			{
+				const Histogram& histogram = phases_[phase];
+				std::fprintf(dump_, ",\"%s\":{\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}", GetPhaseName(static_cast<Phase>(phase)), histogram.GetPercentile(50.0) / 1000.0, histogram.GetPercentile(99.0) / 1000.0, histogram.GetMax() / 1000.0);
+			}
+
+			std::fprintf(dump_, ",\"rays\":%llu", static_cast<unsigned long long>(steps_.GetCount()));
+			std::fprintf(dump_, ",\"steps\":{\"p50\":%llu,\"p99\":%llu,\"max\":%llu}", static_cast<unsigned long long>(steps_.GetPercentile(50.0)), static_cast<unsigned long long>(steps_.GetPercentile(99.0)), static_cast<unsigned long long>(steps_.GetMax()));
+			std::fprintf(dump_, ",\"skips\":{\"p50\":%llu,\"p99\":%llu,\"max\":%llu}}\n", static_cast<unsigned long long>(skips_.GetPercentile(50.0)), static_cast<unsigned long long>(skips_.GetPercentile(99.0)), static_cast<unsigned long long>(skips_.GetMax()));
+		}
+		else
+		{
+			std::fprintf(dump_, "%.6f,%d,%d", seconds, frames, ticks);
+
+			for (int phase = 0; phase < static_cast<int>(Phase::count); ++phase)
+			{
+				const Histogram& histogram = phases_[phase];
+				std::fprintf(dump_, ",%.3f,%.3f,%.3f", histogram.GetPercentile(50.0) / 1000.0, histogram.GetPercentile(99.0) / 1000.0, histogram.GetMax() / 1000.0);
+			}
+
+			std::fprintf(dump_, ",%llu", static_cast<unsigned long long>(steps_.GetCount()));
+			std::fprintf(dump_, ",%llu,%llu,%llu", static_cast<unsigned long long>(steps_.GetPercentile(50.0)), static_cast<unsigned long long>(steps_.GetPercentile(99.0)), static_cast<unsigned long long>(steps_.GetMax()));
+			std::fprintf(dump_, ",%llu,%llu,%llu\n", static_cast<unsigned long long>(skips_.GetPercentile(50.0)), static_cast<unsigned long long>(skips_.GetPercentile(99.0)), static_cast<unsigned long long>(skips_.GetMax()));
+		}
+
+		std::fflush(dump_);
+	}
+
+	for (Histogram& histogram : phases_)
+	{
+		histogram.Clear();
+	}
+
+	steps_.Clear();
+	skips_.Clear();
+	interval_start_ = now;
+}
\ No newline at end of file
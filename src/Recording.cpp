@@ -0,0 +1,194 @@
+#include "Recording.hpp"
+
+#include <cstring>
+
+namespace
+{
+	constexpr char recording_magic[8] = { 'D', 'D', 'A', 'R', 'E', 'C', '\0', '\0' };
+	constexpr std::uint32_t recording_byte_order = 0x01020304;
+	constexpr std::uint32_t recording_version = 1;
+
+	bool IsValid(const RecordingHeader& header)
+	{
+		return std::memcmp(header.magic_, recording_magic, sizeof(recording_magic)) == 0 && header.byte_order_ == recording_byte_order && header.version_ == recording_version &&
+			header.width_ > 0 && header.height_ > 0 && header.cell_size_ > 0 && header.words_per_row_ == dda::WordsPerRow(header.width_);
+	}
+} // namespace
+
+Recorder::Recorder() : file_(nullptr)
+{
+}
+
+Recorder::~Recorder()
+{
+	Close();
+}
+
+bool Recorder::Open(const char* path, const dda::GridView& grid, std::size_t agent_count)
+{
+	Close();
+
+	RecordingHeader header = {};
+	std::memcpy(header.magic_, recording_magic, sizeof(recording_magic));
+	header.byte_order_ = recording_byte_order;
+	header.version_ = recording_version;
+	header.width_ = grid.width_;
+	header.height_ = grid.height_;
+	header.cell_size_ = grid.cell_size_;
+	header.words_per_row_ = grid.words_per_row_;
+	header.agent_count_ = agent_count;
+
+	file_ = std::fopen(path, "wb");
+
+	if (file_ == nullptr)
+	{
+		return false;
+	}
+
+	const std::size_t word_count = static_cast<std::size_t>(grid.words_per_row_) * grid.height_;
+
+	if (std::fwrite(&header, sizeof(header), 1, file_) != 1 || std::fwrite(grid.words_, sizeof(std::uint64_t), word_count, file_) != word_count)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool Recorder::IsOpen() const
+{
+	return file_ != nullptr;
+}
+
+void Recorder::Write(const Controls& controls, dda::Span<const WallEdit> edits)
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	TickRecord record = {};
+	record.vx_ = controls.vx_;
+	record.vy_ = controls.vy_;
+	record.mouse_box_[0] = controls.mouse_box_.x;
+	record.mouse_box_[1] = controls.mouse_box_.y;
+	record.mouse_box_[2] = controls.mouse_box_.w;
+	record.mouse_box_[3] = controls.mouse_box_.h;
+	record.fan_spread_ = controls.fan_spread_;
+	record.mouse_left_pressed_ = controls.mouse_left_pressed_ ? 1 : 0;
+	record.fan_mode_ = static_cast<std::uint8_t>(controls.fan_mode_);
+	record.edit_count_ = static_cast<std::uint32_t>(edits.size());
+
+	std::fwrite(&record, sizeof(record), 1, file_);
+
+	for (const WallEdit& edit : edits)
+	{
+		const EditRecord edit_record = { edit.x_, edit.y_, static_cast<std::uint8_t>(edit.wall_ ? 1 : 0), {} };
+		std::fwrite(&edit_record, sizeof(edit_record), 1, file_);
+	}
+
+	// A session ended by a crash still leaves every tick but the last.
+	std::fflush(file_);
+}
+
+void Recorder::Close()
+{
+	if (file_ != nullptr)
+	{
+		std::fclose(file_);
+		file_ = nullptr;
+	}
+}
+
+Recording::Recording() : header_()
+{
+}
+
+bool Recording::Load(const char* path)
+{
+	std::FILE* file = std::fopen(path, "rb");
+
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	RecordingHeader header;
+
+	if (std::fread(&header, sizeof(header), 1, file) != 1 || !IsValid(header))
+	{
+		std::fclose(file);
+		return false;
+	}
+
+	std::vector<std::uint64_t> words(static_cast<std::size_t>(header.words_per_row_) * header.height_);
+
+	if (std::fread(words.data(), sizeof(std::uint64_t), words.size(), file) != words.size())
+	{
+		std::fclose(file);
+		return false;
+	}
+
+	header_ = header;
+	words_.swap(words);
+	controls_.clear();
+	edits_.clear();
+	edit_offsets_.assign(1, 0);
+
+	TickRecord record;
+
+	while (std::fread(&record, sizeof(record), 1, file) == 1)
+	{
+		const std::size_t first_edit = edits_.size();
+		bool complete = true;
+
+		for (std::uint32_t i = 0; i < record.edit_count_ && complete; ++i)
+		{
+			EditRecord edit;
+			complete = std::fread(&edit, sizeof(edit), 1, file) == 1;
+
+			if (complete)
+			{
+				edits_.push_back({ edit.x_, edit.y_, edit.wall_ != 0 });
+			}
+		}
+
+		if (!complete || record.fan_mode_ > static_cast<std::uint8_t>(FanMode::corners))
+		{
+			edits_.resize(first_edit);
+			break;
+		}
+
+		controls_.push_back({ record.vx_, record.vy_, { record.mouse_box_[0], record.mouse_box_[1], record.mouse_box_[2], record.mouse_box_[3] }, record.mouse_left_pressed_ != 0, static_cast<FanMode>(record.fan_mode_), record.fan_spread_ });
+		edit_offsets_.push_back(edits_.size());
+	}
+
+	std::fclose(file);
+	return true;
+}
+
+dda::GridView Recording::GetWalls() const
+{
+	return { words_.data(), header_.words_per_row_, header_.width_, header_.height_, header_.cell_size_, nullptr, nullptr, nullptr };
+}
+
+std::size_t Recording::GetAgentCount() const
+{
+	return static_cast<std::size_t>(header_.agent_count_);
+}
+
+std::size_t Recording::GetTickCount() const
+{
+	return controls_.size();
+}
+
+const Controls& Recording::GetControls(std::size_t tick) const
+{
+	return controls_[tick];
+}
+
+dda::Span<const WallEdit> Recording::GetEdits(std::size_t tick) const
+{
+	return { edits_.data() + edit_offsets_[tick], edit_offsets_[tick + 1] - edit_offsets_[tick] };
+}
\ No newline at end of file
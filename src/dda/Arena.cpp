@@ -0,0 +1,82 @@
+#include "dda/Arena.hpp"
+
+#include <algorithm>
+
+namespace dda
+{
+	Arena::Arena(std::size_t capacity) : used_(0), spilled_(0)
+	{
+		if (capacity > 0)
+		{
+			blocks_.push_back({ std::make_unique<unsigned char[]>(capacity), capacity });
+		}
+	}
+
+	void* Arena::AllocateBytes(std::size_t size, std::size_t alignment)
+	{
+		if (size == 0)
+		{
+			return nullptr;
+		}
+
+		if (!blocks_.empty())
+		{
+			const std::size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+
+			if (offset + size <= blocks_.back().size_)
+			{
+				used_ = offset + size;
+				return blocks_.back().data_.get() + offset;
+			}
+
+			spilled_ += used_;
+		}
+
+		// Out of room: double the capacity with a new block, which starts
+		// aligned for any fundamental type.
+		const std::size_t block_size = std::max(size, GetCapacity());
+
+		blocks_.push_back({ std::make_unique<unsigned char[]>(block_size), block_size });
+		used_ = size;
+		return blocks_.back().data_.get();
+	}
+
+	void Arena::ReleaseBytes(const void* end, std::size_t size)
+	{
+		if (!blocks_.empty() && end == blocks_.back().data_.get() + used_)
+		{
+			used_ -= size;
+		}
+	}
+
+	void Arena::Reset()
+	{
+		if (blocks_.size() > 1)
+		{
+			const std::size_t capacity = GetCapacity();
+
+			blocks_.clear();
+			blocks_.push_back({ std::make_unique<unsigned char[]>(capacity), capacity });
+		}
+
+		used_ = 0;
+		spilled_ = 0;
+	}
+
+	std::size_t Arena::GetUsed() const
+	{
+		return spilled_ + used_;
+	}
+
+	std::size_t Arena::GetCapacity() const
+	{
+		std::size_t capacity = 0;
+
+		for (const Block& block : blocks_)
+		{
+			capacity += block.size_;
+		}
+
+		return capacity;
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "dda/ChunkedWorld.hpp"
+#include "Traversal.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace dda
+{
+	namespace
+	{
+		/*
+		 * Cell source for TraverseRaySkipping that looks cells up in the
+		 * chunk holding them. The current chunk is kept until the ray leaves
+		 * it, so the world is only consulted once per chunk crossed, and
+		 * each newly entered chunk prefetches its neighbours along the ray.
+		 */
+		class ChunkCursor
+		{
+		private:
+			ChunkedWorld& world_;
+			Vector2d<int> step_;
+			int chunk_shift_;
+			int chunk_mask_;
+			int width_;
+			int height_;
+			Vector2d<int> chunk_position_;
+			std::shared_ptr<const ChunkedWorld::Chunk> chunk_;
+			GridView view_;
+
+			void Select(int x, int y)
+			{
+				const Vector2d<int> position = { x >> chunk_shift_, y >> chunk_shift_ };
+
+				if (position.x == chunk_position_.x && position.y == chunk_position_.y)
+				{
+					return;
+				}
+
+				chunk_position_ = position;
+				chunk_ = world_.Acquire(position.x, position.y);
+
+				if (chunk_ != nullptr)
+				{
+					view_ = chunk_->grid_.GetView();
+				}
+
+				if (step_.x != 0)
+				{
+					world_.Prefetch(position.x + step_.x, position.y);
+				}
+
+				if (step_.y != 0)
+				{
+					world_.Prefetch(position.x, position.y + step_.y);
+				}
+
+				if (step_.x != 0 && step_.y != 0)
+				{
+					world_.Prefetch(position.x + step_.x, position.y + step_.y);
+				}
+			}
+
+		public:
+			int cell_size_;
+
+			ChunkCursor(ChunkedWorld& world, const Vector2d<int>& step) :
+				world_(world),
+				step_(step),
+				chunk_shift_(world.GetChunkShift()),
+				chunk_mask_((1 << world.GetChunkShift()) - 1),
+				width_(world.GetWidth()),
+				height_(world.GetHeight()),
+				chunk_position_{ -1, -1 },
+				view_{ nullptr, 0, 0, 0, 1, nullptr, nullptr, nullptr },
+				cell_size_(world.GetCellSize())
+			{
+			}
+
+			int GetEmptyBlockShift(int x, int y)
+			{
+				if (x < 0 || x >= width_ || y < 0 || y >= height_)
+				{
+					return 0;
+				}
+
+				Select(x, y);
+
+				if (chunk_ == nullptr)
+				{
+					return 0;
+				}
+
+				return chunk_->empty_ ? chunk_shift_ : view_.GetEmptyBlockShift(x & chunk_mask_, y & chunk_mask_);
+			}
+
+			bool IsWall(int x, int y)
+			{
+				if (x < 0 || x >= width_ || y < 0 || y >= height_)
+				{
+					return false;
+				}
+
+				Select(x, y);
+				return chunk_ == nullptr || view_.IsWall(x & chunk_mask_, y & chunk_mask_);
+			}
+		};
+	} // namespace
+
+	ChunkedWorld::ChunkedWorld(int width, int height, int cell_size, int chunk_shift, std::size_t capacity, Loader loader, Missing missing) :
+		width_(width),
+		height_(height),
+		cell_size_(cell_size),
+		chunk_shift_(chunk_shift),
+		capacity_(std::max<std::size_t>(capacity, 1)),
+		loader_(std::move(loader)),
+		missing_(missing),
+		stopping_(false)
+	{
+		prefetcher_ = std::thread(&ChunkedWorld::RunPrefetcher, this);
+	}
+
+	ChunkedWorld::~ChunkedWorld()
+	{
+		{
+			const std::lock_guard<std::mutex> lock(mutex_);
+			stopping_ = true;
+		}
+
+		requested_.notify_all();
+		prefetcher_.join();
+	}
+
+	int ChunkedWorld::GetWidth() const
+	{
+		return width_;
+	}
+
+	int ChunkedWorld::GetHeight() const
+	{
+		return height_;
+	}
+
+	int ChunkedWorld::GetCellSize() const
+	{
+		return cell_size_;
+	}
+
+	int ChunkedWorld::GetChunkShift() const
+	{
+		return chunk_shift_;
+	}
+
+	GridView ChunkedWorld::GetBounds() const
+	{
+		return { nullptr, 0, width_, height_, cell_size_, nullptr, nullptr, nullptr };
+	}
+
+	std::uint64_t ChunkedWorld::GetKey(int chunk_x, int chunk_y)
+	{
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunk_y)) << 32) | static_cast<std::uint32_t>(chunk_x);
+	}
+
+	std::shared_ptr<const ChunkedWorld::Chunk> ChunkedWorld::Load(int chunk_x, int chunk_y) const
+	{
+		const int size = 1 << chunk_shift_;
+		const std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>(Chunk{ Grid(size, size, cell_size_), true });
+
+		loader_(chunk_x, chunk_y, chunk->grid_);
+		chunk->grid_.ClearDirtyRegion();
+
+		const GridView view = chunk->grid_.GetView();
+		chunk->empty_ = std::all_of(view.words_, view.words_ + static_cast<std::size_t>(view.words_per_row_) * view.height_, [](std::uint64_t word) { return word == 0; });
+		return chunk;
+	}
+
+	void ChunkedWorld::Insert(std::uint64_t key, std::shared_ptr<const Chunk> chunk)
+	{
+		while (resident_.size() >= capacity_)
+		{
+			resident_.erase(lru_.back());
+			lru_.pop_back();
+		}
+
+		lru_.push_front(key);
+		resident_.emplace(key, std::make_pair(std::move(chunk), lru_.begin()));
+	}
+
+	std::shared_ptr<const ChunkedWorld::Chunk> ChunkedWorld::Acquire(int chunk_x, int chunk_y)
+	{
+		if (chunk_x < 0 || chunk_y < 0 || chunk_x > ((width_ - 1) >> chunk_shift_) || chunk_y > ((height_ - 1) >> chunk_shift_))
+		{
+			return nullptr;
+		}
+
+		const std::uint64_t key = GetKey(chunk_x, chunk_y);
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		while (true)
+		{
+			const auto found = resident_.find(key);
+
+			if (found != resident_.end())
+			{
+				lru_.splice(lru_.begin(), lru_, found->second.second);
+				return found->second.first;
+			}
+
+			if (loading_.count(key) == 0)
+			{
+				break;
+			}
+
+			if (missing_ == Missing::wall)
+			{
+				return nullptr;
+			}
+
+			loaded_.wait(lock);
+		}
+
+		if (missing_ == Missing::wall)
+		{
+			lock.unlock();
+			Prefetch(chunk_x, chunk_y);
+			return nullptr;
+		}
+
+		loading_.insert(key);
+		lock.unlock();
+
+		std::shared_ptr<const Chunk> chunk = Load(chunk_x, chunk_y);
+
+		lock.lock();
+		loading_.erase(key);
+		Insert(key, chunk);
+		lock.unlock();
+		loaded_.notify_all();
+
+		return chunk;
+	}
+
+	void ChunkedWorld::Prefetch(int chunk_x, int chunk_y)
+	{
+		if (chunk_x < 0 || chunk_y < 0 || chunk_x > ((width_ - 1) >> chunk_shift_) || chunk_y > ((height_ - 1) >> chunk_shift_))
+		{
+			return;
+		}
+
+		const std::uint64_t key = GetKey(chunk_x, chunk_y);
+
+		{
+			const std::lock_guard<std::mutex> lock(mutex_);
+
+			if (resident_.count(key) != 0 || loading_.count(key) != 0)
+			{
+				return;
+			}
+
+			loading_.insert(key);
+			requests_.push_back(key);
+		}
+
+		requested_.notify_one();
+	}
+
+	void ChunkedWorld::RunPrefetcher()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		while (true)
+		{
+			requested_.wait(lock, [this] { return stopping_ || !requests_.empty(); });
+
+			if (stopping_)
+			{
+				return;
+			}
+
+			const std::uint64_t key = requests_.front();
+			requests_.pop_front();
+			lock.unlock();
+
+			std::shared_ptr<const Chunk> chunk = Load(static_cast<int>(static_cast<std::uint32_t>(key)), static_cast<int>(key >> 32));
+
+			lock.lock();
+			loading_.erase(key);
+			Insert(key, std::move(chunk));
+			loaded_.notify_all();
+		}
+	}
+
+	bool ChunkedWorld::IsResident(int x, int y) const
+	{
+		const std::lock_guard<std::mutex> lock(mutex_);
+		return resident_.count(GetKey(x >> chunk_shift_, y >> chunk_shift_)) != 0;
+	}
+
+	std::size_t ChunkedWorld::GetResidentCount() const
+	{
+		const std::lock_guard<std::mutex> lock(mutex_);
+		return resident_.size();
+	}
+
+	RayHit ChunkedWorld::Cast(const Vector2d<float>& origin, const Vector2d<float>& direction, float max_distance)
+	{
+		const RaySetup setup = MakeRaySetup(GetBounds(), origin, direction, max_distance);
+		ChunkCursor cursor(*this, setup.step_);
+		return TraverseRaySkipping(cursor, setup);
+	}
+
+	void ChunkedWorld::CopyChunk(const GridView& source, int chunk_x, int chunk_y, Grid& chunk)
+	{
+		const int left = chunk_x * chunk.GetWidth();
+		const int top = chunk_y * chunk.GetHeight();
+
+		for (int y = 0; y < chunk.GetHeight() && top + y < source.height_; ++y)
+		{
+			for (int x = 0; x < chunk.GetWidth() && left + x < source.width_; ++x)
+			{
+				if (source.IsWall(left + x, top + y))
+				{
+					chunk.SetWall(x, y, true);
+				}
+			}
+		}
+	}
+} // namespace dda
\ No newline at end of file
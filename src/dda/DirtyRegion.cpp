@@ -0,0 +1,79 @@
+#include "dda/DirtyRegion.hpp"
+
+#include <cstddef>
+
+namespace dda
+{
+	DirtyRegion::DirtyRegion() : tiles_width_(0), tiles_height_(0), all_(false)
+	{
+	}
+
+	DirtyRegion::DirtyRegion(int width, int height) :
+		tiles_width_((width + (1 << tile_shift) - 1) >> tile_shift),
+		tiles_height_((height + (1 << tile_shift) - 1) >> tile_shift),
+		all_(false),
+		marked_(static_cast<std::size_t>(tiles_width_) * static_cast<std::size_t>(tiles_height_), 0)
+	{
+	}
+
+	int DirtyRegion::GetTilesWidth() const
+	{
+		return tiles_width_;
+	}
+
+	int DirtyRegion::GetTilesHeight() const
+	{
+		return tiles_height_;
+	}
+
+	void DirtyRegion::MarkCell(int x, int y)
+	{
+		const int tile_x = x >> tile_shift;
+		const int tile_y = y >> tile_shift;
+
+		if (all_ || tile_x < 0 || tile_x >= tiles_width_ || tile_y < 0 || tile_y >= tiles_height_)
+		{
+			return;
+		}
+
+		std::uint8_t& marked = marked_[static_cast<std::size_t>(tile_y) * tiles_width_ + tile_x];
+
+		if (marked == 0)
+		{
+			marked = 1;
+			tiles_.push_back({ tile_x, tile_y });
+		}
+	}
+
+	void DirtyRegion::MarkAll()
+	{
+		Clear();
+		all_ = true;
+	}
+
+	bool DirtyRegion::IsEmpty() const
+	{
+		return !all_ && tiles_.empty();
+	}
+
+	bool DirtyRegion::IsAll() const
+	{
+		return all_;
+	}
+
+	Span<const Vector2d<int>> DirtyRegion::GetTiles() const
+	{
+		return tiles_;
+	}
+
+	void DirtyRegion::Clear()
+	{
+		for (const Vector2d<int>& tile : tiles_)
+		{
+			marked_[static_cast<std::size_t>(tile.y) * tiles_width_ + tile.x] = 0;
+		}
+
+		tiles_.clear();
+		all_ = false;
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "dda/DistanceField.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+static_assert(dda::DistanceField::max_clearance < 255, "clearances plus one must fit in a byte");
+
+namespace dda
+{
+	DistanceField::DistanceField() : width_(0), height_(0)
+	{
+	}
+
+	DistanceField::DistanceField(const GridView& grid) : width_(0), height_(0)
+	{
+		Build(grid);
+	}
+
+	void DistanceField::Compute(const GridView& grid, int min_x, int min_y, int max_x, int max_y)
+	{
+		// Walls up to max_clearance cells beyond the cells recomputed can
+		// still be their nearest, so the passes run over a margin that wide.
+		const int source_min_x = std::max(min_x - max_clearance, 0);
+		const int source_min_y = std::max(min_y - max_clearance, 0);
+		const int source_max_x = std::min(max_x + max_clearance, width_ - 1);
+		const int source_max_y = std::min(max_y + max_clearance, height_ - 1);
+
+		min_x = std::max(min_x, 0);
+		min_y = std::max(min_y, 0);
+		max_x = std::min(max_x, width_ - 1);
+		max_y = std::min(max_y, height_ - 1);
+
+		if (min_x > max_x || min_y > max_y)
+		{
+			return;
+		}
+
+		const int width = source_max_x - source_min_x + 1;
+		const int height = source_max_y - source_min_y + 1;
+
+		scratch_.resize(static_cast<std::size_t>(width) * height);
+		std::uint8_t* distances = scratch_.data();
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				distances[static_cast<std::size_t>(y) * width + x] = grid.IsWall(source_min_x + x, source_min_y + y) ? 0 : max_clearance;
+			}
+		}
+
+		// Two chamfer passes with unit weights on all eight neighbours give
+		// the exact Chebyshev distance: forward from the upper and left
+		// neighbours, then backward from the lower and right ones.
+		const auto relax = [&](std::size_t i, std::size_t neighbour)
+		{
+			distances[i] = std::min<std::uint8_t>(distances[i], static_cast<std::uint8_t>(distances[neighbour] + 1));
+		};
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				const std::size_t i = static_cast<std::size_t>(y) * width + x;
+
+				if (x > 0)
+				{
+					relax(i, i - 1);
+				}
+
+				if (y > 0)
+				{
+					relax(i, i - width);
+
+					if (x > 0)
+					{
+						relax(i, i - width - 1);
+					}
+
+					if (x < width - 1)
+					{
+						relax(i, i - width + 1);
+					}
+				}
+			}
+		}
+
+		for (int y = height - 1; y >= 0; --y)
+		{
+			for (int x = width - 1; x >= 0; --x)
+			{
+				const std::size_t i = static_cast<std::size_t>(y) * width + x;
+
+				if (x < width - 1)
+				{
+					relax(i, i + 1);
+				}
+
+				if (y < height - 1)
+				{
+					relax(i, i + width);
+
+					if (x < width - 1)
+					{
+						relax(i, i + width + 1);
+					}
+
+					if (x > 0)
+					{
+						relax(i, i + width - 1);
+					}
+				}
+			}
+		}
+
+		for (int y = min_y; y <= max_y; ++y)
+		{
+			const std::uint8_t* source = distances + static_cast<std::size_t>(y - source_min_y) * width + (min_x - source_min_x);
+			std::copy(source, source + (max_x - min_x + 1), clearances_.begin() + static_cast<std::size_t>(y) * width_ + min_x);
+		}
+	}
+
+	void DistanceField::Build(const GridView& grid)
+	{
+		width_ = grid.width_;
+		height_ = grid.height_;
+		clearances_.assign(static_cast<std::size_t>(width_) * height_, 0);
+		Compute(grid, 0, 0, width_ - 1, height_ - 1);
+	}
+
+	void DistanceField::Update(const GridView& grid, const DirtyRegion& dirty)
+	{
+		if (dirty.IsAll() || grid.width_ != width_ || grid.height_ != height_)
+		{
+			Build(grid);
+			return;
+		}
+
+		constexpr int tile_cells = 1 << DirtyRegion::tile_shift;
+
+		// Only cells closer than max_clearance to an edit can change.
+		constexpr int reach = max_clearance - 1;
+		constexpr std::size_t tile_cost = static_cast<std::size_t>(tile_cells + 2 * (reach + max_clearance)) * (tile_cells + 2 * (reach + max_clearance));
+
+		// Past this many tiles, rebuilding the whole field is cheaper.
+		if (dirty.GetTiles().size() * tile_cost > clearances_.size())
+		{
+			Build(grid);
+			return;
+		}
+
+		for (const Vector2d<int>& tile : dirty.GetTiles())
+		{
+			const int min_x = tile.x * tile_cells;
+			const int min_y = tile.y * tile_cells;
+
+			Compute(grid, min_x - reach, min_y - reach, min_x + tile_cells - 1 + reach, min_y + tile_cells - 1 + reach);
+		}
+	}
+
+	int DistanceField::GetClearance(int x, int y) const
+	{
+		if (x < 0 || x >= width_ || y < 0 || y >= height_)
+		{
+			return 0;
+		}
+
+		return clearances_[static_cast<std::size_t>(y) * width_ + x];
+	}
+
+	GridView DistanceField::Attach(const GridView& grid) const
+	{
+		GridView view = grid;
+		view.clearances_ = grid.width_ == width_ && grid.height_ == height_ ? clearances_.data() : nullptr;
+		return view;
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include "dda/FixedPoint.hpp"
+
+#include <algorithm>
+
+namespace dda
+{
+	namespace
+	{
+		/* Stands in for "no boundary on this axis"; small enough that products with direction components cannot overflow. */
+		constexpr std::int64_t never = std::int64_t{ 1 } << 46;
+
+		/* Upper bound for max_distance, to keep the per-axis limits in range. */
+		constexpr std::int64_t distance_cap = std::int64_t{ 1 } << 40;
+
+		/* Extra fractional bits carried by the direction length. */
+		constexpr int length_shift = 10;
+
+		template <int CellShift>
+		struct PowerOfTwoCells
+		{
+			static constexpr int shift = CellShift + fixed_shift;
+
+			int CellOf(std::int64_t value) const
+			{
+				return static_cast<int>(value >> shift);
+			}
+
+			std::int64_t CellStart(int cell) const
+			{
+				return static_cast<std::int64_t>(cell) * Size();
+			}
+
+			std::int64_t Size() const
+			{
+				return std::int64_t{ 1 } << shift;
+			}
+		};
+
+		struct RuntimeCells
+		{
+			std::int64_t size_;
+
+			int CellOf(std::int64_t value) const
+			{
+				const std::int64_t quotient = value / size_;
+				return static_cast<int>((value % size_ != 0 && value < 0) ? quotient - 1 : quotient);
+			}
+
+			std::int64_t CellStart(int cell) const
+			{
+				return static_cast<std::int64_t>(cell) * size_;
+			}
+
+			std::int64_t Size() const
+			{
+				return size_;
+			}
+		};
+
+		/*
+		 * Rounded-down square root. IEEE 754 square roots are exact to half
+		 * an ulp on every platform, and value stays below 2^53, where a
+		 * double holds it exactly; the correction only guards the last step
+		 * so the result never depends on how the platform rounds.
+		 */
+		std::int64_t ISqrt(std::uint64_t value)
+		{
+			std::uint64_t result = static_cast<std::uint64_t>(std::sqrt(static_cast<double>(value)));
+
+			while (result * result > value)
+			{
+				--result;
+			}
+
+			while ((result + 1) * (result + 1) <= value)
+			{
+				++result;
+			}
+
+			return static_cast<std::int64_t>(result);
+		}
+
+		/* value * numerator / denominator, rounded down, without overflowing the intermediate product. */
+		std::int64_t ScaleDivide(std::int64_t value, std::int64_t numerator, std::int64_t denominator)
+		{
+			const std::int64_t quotient = value / denominator;
+			const std::int64_t remainder = value % denominator;
+			return quotient * numerator + remainder * numerator / denominator;
+		}
+
+		/* Rescales direction so its largest component lies in [2^14, 2^16), which bounds both precision loss and overflow. */
+		void NormalizeDirection(std::int64_t& dx, std::int64_t& dy)
+		{
+			while (std::max(std::abs(dx), std::abs(dy)) >= (std::int64_t{ 1 } << 16))
+			{
+				dx /= 2;
+				dy /= 2;
+			}
+
+			while (std::max(std::abs(dx), std::abs(dy)) < (std::int64_t{ 1 } << 14))
+			{
+				dx *= 2;
+				dy *= 2;
+			}
+		}
+
+		FixedHit MakeFixedMiss()
+		{
+			return { false, { -1, -1 }, { -1, -1 }, 0, HitFace::none };
+		}
+
+		/*
+		 * Inside is whether the origin's cell lies in the grid. Those rays
+		 * fold the grid's far edges into their per-axis limits, which the
+		 * loop checks anyway, so only rays from outside test the bounds on
+		 * every step.
+		 */
+		template <bool Inside, typename Cells>
+		FixedHit TraverseFixed(const GridView& grid, const Cells& cells, const Vector2d<Fixed>& origin, const Vector2d<Fixed>& direction, std::int64_t max_distance)
+		{
+			std::int64_t dx = direction.x;
+			std::int64_t dy = direction.y;
+
+			if (dx == 0 && dy == 0)
+			{
+				return MakeFixedMiss();
+			}
+
+			NormalizeDirection(dx, dy);
+
+			const std::int64_t abs_dx = std::abs(dx);
+			const std::int64_t abs_dy = std::abs(dy);
+			const std::int64_t length = ISqrt(static_cast<std::uint64_t>(dx * dx + dy * dy) << (2 * length_shift));
+			const std::int64_t size = cells.Size();
+			max_distance = std::clamp<std::int64_t>(max_distance, 0, distance_cap);
+
+			const Vector2d<int> step = { dx < 0 ? -1 : (dx > 0 ? 1 : 0), dy < 0 ? -1 : (dy > 0 ? 1 : 0) };
+			Vector2d<int> map_check = { cells.CellOf(origin.x), cells.CellOf(origin.y) };
+
+			// Distance travelled along each axis when the ray reaches that
+			// axis' next cell boundary, and when it has gone max_distance.
+			std::int64_t next_x = step.x > 0 ? cells.CellStart(map_check.x + 1) - origin.x : (step.x < 0 ? origin.x - cells.CellStart(map_check.x) : never);
+			std::int64_t next_y = step.y > 0 ? cells.CellStart(map_check.y + 1) - origin.y : (step.y < 0 ? origin.y - cells.CellStart(map_check.y) : never);
+			std::int64_t limit_x = step.x != 0 ? ScaleDivide(max_distance, abs_dx << length_shift, length) : -1;
+			std::int64_t limit_y = step.y != 0 ? ScaleDivide(max_distance, abs_dy << length_shift, length) : -1;
+
+			// Crossing the far edge of the grid is the step whose travelled
+			// distance equals the edge's, so the limit stops just short of it.
+			if (Inside)
+			{
+				limit_x = std::min(limit_x, step.x > 0 ? cells.CellStart(grid.width_) - origin.x - 1 : origin.x - 1);
+				limit_y = std::min(limit_y, step.y > 0 ? cells.CellStart(grid.height_) - origin.y - 1 : origin.y - 1);
+			}
+
+			// Cross-multiplied forms of next_x and next_y, kept incrementally so
+			// that next_x / |dx| < next_y / |dy| needs no multiply per step.
+			std::int64_t cross_x = next_x * abs_dy;
+			std::int64_t cross_y = next_y * abs_dx;
+			const std::int64_t cross_step_x = size * abs_dy;
+			const std::int64_t cross_step_y = size * abs_dx;
+
+			while (true)
+			{
+				const bool on_x = cross_x < cross_y;
+				std::int64_t travelled;
+				HitFace face;
+
+				if (on_x)
+				{
+					travelled = next_x;
+
+					if (travelled > limit_x)
+					{
+						break;
+					}
+
+					map_check.x += step.x;
+					next_x += size;
+					cross_x += cross_step_x;
+					face = step.x > 0 ? HitFace::west : HitFace::east;
+				}
+				else
+				{
+					travelled = next_y;
+
+					if (travelled > limit_y)
+					{
+						break;
+					}
+
+					map_check.y += step.y;
+					next_y += size;
+					cross_y += cross_step_y;
+					face = step.y > 0 ? HitFace::north : HitFace::south;
+				}
+
+				if (!Inside && ((map_check.x < 0 && step.x <= 0) || (map_check.x >= grid.width_ && step.x >= 0) || (map_check.y < 0 && step.y <= 0) || (map_check.y >= grid.height_ && step.y >= 0)))
+				{
+					break;
+				}
+
+				if (grid.IsWall(map_check.x, map_check.y))
+				{
+					const std::int64_t axis = on_x ? abs_dx : abs_dy;
+					return { true, map_check, { origin.x + dx * travelled / axis, origin.y + dy * travelled / axis }, ScaleDivide(travelled, length, axis) >> length_shift, face };
+				}
+			}
+
+			return MakeFixedMiss();
+		}
+
+		template <typename Cells>
+		FixedHit TraverseFixed(const GridView& grid, const Cells& cells, const Vector2d<Fixed>& origin, const Vector2d<Fixed>& direction, std::int64_t max_distance)
+		{
+			if (grid.Contains(cells.CellOf(origin.x), cells.CellOf(origin.y)))
+			{
+				return TraverseFixed<true>(grid, cells, origin, direction, max_distance);
+			}
+
+			return TraverseFixed<false>(grid, cells, origin, direction, max_distance);
+		}
+	} // namespace
+
+	template <int CellShift>
+	FixedHit CastFixed(const GridView& grid, const Vector2d<Fixed>& origin, const Vector2d<Fixed>& direction, std::int64_t max_distance)
+	{
+		return TraverseFixed(grid, PowerOfTwoCells<CellShift>(), origin, direction, max_distance);
+	}
+
+	template FixedHit CastFixed<0>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<1>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<2>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<3>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<4>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<5>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<6>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<7>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+	template FixedHit CastFixed<8>(const GridView&, const Vector2d<Fixed>&, const Vector2d<Fixed>&, std::int64_t);
+
+	FixedHit CastFixed(const GridView& grid, const Vector2d<Fixed>& origin, const Vector2d<Fixed>& direction, std::int64_t max_distance)
+	{
+		switch (grid.cell_size_)
+		{
+			case 1:
+				return CastFixed<0>(grid, origin, direction, max_distance);
+			case 2:
+				return CastFixed<1>(grid, origin, direction, max_distance);
+			case 4:
+				return CastFixed<2>(grid, origin, direction, max_distance);
+			case 8:
+				return CastFixed<3>(grid, origin, direction, max_distance);
+			case 16:
+				return CastFixed<4>(grid, origin, direction, max_distance);
+			case 32:
+				return CastFixed<5>(grid, origin, direction, max_distance);
+			case 64:
+				return CastFixed<6>(grid, origin, direction, max_distance);
+			case 128:
+				return CastFixed<7>(grid, origin, direction, max_distance);
+			case 256:
+				return CastFixed<8>(grid, origin, direction, max_distance);
+			default:
+				return TraverseFixed(grid, RuntimeCells{ static_cast<std::int64_t>(grid.cell_size_) << fixed_shift }, origin, direction, max_distance);
+		}
+	}
+
+	std::size_t CastFixedBatch(const GridView& grid, Span<const Vector2d<Fixed>> origins, Span<const Vector2d<Fixed>> directions, std::int64_t max_distance, Span<FixedHit> results)
+	{
+		const std::size_t count = std::min({ origins.size(), directions.size(), results.size() });
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			results[i] = CastFixed(grid, origins[i], directions[i], max_distance);
+		}
+
+		return count;
+	}
+} // namespace dda
\ No newline at end of file
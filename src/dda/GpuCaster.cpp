@@ -0,0 +1,403 @@
+#include "dda/GpuCaster.hpp"
+#include "Traversal.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_WIN32)
+#define DDA_GL_API __stdcall
+#else
+#define DDA_GL_API
+#endif
+
+namespace dda
+{
+	namespace
+	{
+		using GLenum = unsigned int;
+		using GLuint = unsigned int;
+		using GLint = int;
+		using GLsizei = int;
+		using GLbitfield = unsigned int;
+		using GLchar = char;
+		using GLubyte = unsigned char;
+		using GLintptr = std::ptrdiff_t;
+		using GLsizeiptr = std::ptrdiff_t;
+
+		constexpr GLenum gl_renderer = 0x1F01;
+		constexpr GLenum gl_major_version = 0x821B;
+		constexpr GLenum gl_minor_version = 0x821C;
+		constexpr GLenum gl_compute_shader = 0x91B9;
+		constexpr GLenum gl_compile_status = 0x8B81;
+		constexpr GLenum gl_link_status = 0x8B82;
+		constexpr GLenum gl_shader_storage_buffer = 0x90D2;
+		constexpr GLenum gl_stream_draw = 0x88E0;
+		constexpr GLenum gl_stream_read = 0x88E1;
+		constexpr GLenum gl_static_draw = 0x88E4;
+		constexpr GLbitfield gl_buffer_update_barrier_bit = 0x00000200;
+
+		/* One invocation per ray; the rays of a batch are dispatched in slices of at most max_groups groups. */
+		constexpr GLuint group_size = 64;
+		constexpr GLuint max_groups = 65535;
+
+		/*
+		 * Same loop as TraverseRay. Walls are read as 32-bit halves of the
+		 * grid's 64-bit words, which on little-endian hosts is the same bit
+		 * order. Faces are HitFace values.
+		 */
+		constexpr const char* shader_source = R"(#version 430
+layout(local_size_x = 64) in;
+
+struct Ray
+{
+	vec2 ray_length;
+	vec2 ray_step_size;
+	ivec2 map_check;
+	ivec2 step;
+	float limit;
+	int valid;
+};
+
+struct Hit
+{
+	ivec2 cell;
+	float distance;
+	int face;
+};
+
+layout(std430, binding = 0) readonly buffer Words { uint words[]; };
+layout(std430, binding = 1) readonly buffer Rays { Ray rays[]; };
+layout(std430, binding = 2) writeonly buffer Hits { Hit hits[]; };
+
+uniform ivec2 grid_size;
+uniform uint words_per_row;
+uniform uint first;
+uniform uint count;
+
+bool IsWall(ivec2 cell)
+{
+	if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, grid_size)))
+	{
+		return false;
+	}
+
+	return ((words[uint(cell.y) * words_per_row + (uint(cell.x) >> 5)] >> (uint(cell.x) & 31u)) & 1u) != 0u;
+}
+
+void main()
+{
+	uint index = first + gl_GlobalInvocationID.x;
+
+	if (index >= count)
+	{
+		return;
+	}
+
+	Ray ray = rays[index];
+	Hit hit = Hit(ivec2(-1), 0.0, 0);
+
+	if (ray.valid != 0)
+	{
+		precise vec2 ray_length = ray.ray_length;
+		ivec2 map_check = ray.map_check;
+		precise float distance = 0.0;
+
+		// Setups are only valid if the loop reaches the limit; the bound on
+		// the cells a ray can cross keeps a bad one from hanging the device.
+		int steps_left = grid_size.x + grid_size.y + 2;
+
+		while (distance <= ray.limit && steps_left-- > 0)
+		{
+			int face;
+
+			if (ray_length.x < ray_length.y)
+			{
+				map_check.x += ray.step.x;
+				distance = ray_length.x;
+				ray_length.x += ray.ray_step_size.x;
+				face = ray.step.x > 0 ? 1 : 2;
+			}
+			else
+			{
+				map_check.y += ray.step.y;
+				distance = ray_length.y;
+				ray_length.y += ray.ray_step_size.y;
+				face = ray.step.y > 0 ? 3 : 4;
+			}
+
+			if (distance > ray.limit)
+			{
+				break;
+			}
+
+			if (IsWall(map_check))
+			{
+				hit = Hit(map_check, distance, face);
+				break;
+			}
+		}
+	}
+
+	hits[index] = hit;
+}
+)";
+
+		/* std430 layouts of the shader's Ray and Hit. */
+		struct GpuRay
+		{
+			float ray_length_[2];
+			float ray_step_size_[2];
+			std::int32_t map_check_[2];
+			std::int32_t step_[2];
+			float limit_;
+			std::int32_t valid_;
+		};
+
+		struct GpuHit
+		{
+			std::int32_t cell_[2];
+			float distance_;
+			std::int32_t face_;
+		};
+
+		static_assert(sizeof(GpuRay) == 40, "GpuRay must match the std430 layout of Ray");
+		static_assert(sizeof(GpuHit) == 16, "GpuHit must match the std430 layout of Hit");
+
+		enum Buffer
+		{
+			words_buffer,
+			rays_buffer,
+			hits_buffer,
+			buffer_count
+		};
+	} // namespace
+
+	struct GpuCaster::Device
+	{
+		const GLubyte* (DDA_GL_API* GetString)(GLenum name);
+		void (DDA_GL_API* GetIntegerv)(GLenum name, GLint* data);
+		GLuint (DDA_GL_API* CreateShader)(GLenum type);
+		void (DDA_GL_API* ShaderSource)(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths);
+		void (DDA_GL_API* CompileShader)(GLuint shader);
+		void (DDA_GL_API* GetShaderiv)(GLuint shader, GLenum name, GLint* value);
+		void (DDA_GL_API* DeleteShader)(GLuint shader);
+		GLuint (DDA_GL_API* CreateProgram)();
+		void (DDA_GL_API* AttachShader)(GLuint program, GLuint shader);
+		void (DDA_GL_API* LinkProgram)(GLuint program);
+		void (DDA_GL_API* GetProgramiv)(GLuint program, GLenum name, GLint* value);
+		void (DDA_GL_API* DeleteProgram)(GLuint program);
+		void (DDA_GL_API* UseProgram)(GLuint program);
+		GLint (DDA_GL_API* GetUniformLocation)(GLuint program, const GLchar* name);
+		void (DDA_GL_API* Uniform2i)(GLint location, GLint x, GLint y);
+		void (DDA_GL_API* Uniform1ui)(GLint location, GLuint value);
+		void (DDA_GL_API* GenBuffers)(GLsizei count, GLuint* buffers);
+		void (DDA_GL_API* DeleteBuffers)(GLsizei count, const GLuint* buffers);
+		void (DDA_GL_API* BindBuffer)(GLenum target, GLuint buffer);
+		void (DDA_GL_API* BindBufferBase)(GLenum target, GLuint index, GLuint buffer);
+		void (DDA_GL_API* BufferData)(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+		void (DDA_GL_API* GetBufferSubData)(GLenum target, GLintptr offset, GLsizeiptr size, void* data);
+		void (DDA_GL_API* DispatchCompute)(GLuint x, GLuint y, GLuint z);
+		void (DDA_GL_API* Barrier)(GLbitfield barriers);
+
+		GLuint program_;
+		GLuint buffers_[buffer_count];
+		GLint grid_size_;
+		GLint words_per_row_;
+		GLint first_;
+		GLint count_;
+
+		std::vector<RaySetup> setups_;
+		std::vector<GpuRay> rays_;
+		std::vector<GpuHit> hits_;
+
+		template <typename Function>
+		static bool Load(LoadProc load, const char* name, Function& function)
+		{
+			function = reinterpret_cast<Function>(load(name));
+			return function != nullptr;
+		}
+
+		bool LoadAll(LoadProc load)
+		{
+			return Load(load, "glGetString", GetString) && Load(load, "glGetIntegerv", GetIntegerv) &&
+				Load(load, "glCreateShader", CreateShader) && Load(load, "glShaderSource", ShaderSource) && Load(load, "glCompileShader", CompileShader) && Load(load, "glGetShaderiv", GetShaderiv) && Load(load, "glDeleteShader", DeleteShader) &&
+				Load(load, "glCreateProgram", CreateProgram) && Load(load, "glAttachShader", AttachShader) && Load(load, "glLinkProgram", LinkProgram) && Load(load, "glGetProgramiv", GetProgramiv) && Load(load, "glDeleteProgram", DeleteProgram) && Load(load, "glUseProgram", UseProgram) &&
+				Load(load, "glGetUniformLocation", GetUniformLocation) && Load(load, "glUniform2i", Uniform2i) && Load(load, "glUniform1ui", Uniform1ui) &&
+				Load(load, "glGenBuffers", GenBuffers) && Load(load, "glDeleteBuffers", DeleteBuffers) && Load(load, "glBindBuffer", BindBuffer) && Load(load, "glBindBufferBase", BindBufferBase) && Load(load, "glBufferData", BufferData) && Load(load, "glGetBufferSubData", GetBufferSubData) &&
+				Load(load, "glDispatchCompute", DispatchCompute) && Load(load, "glMemoryBarrier", Barrier);
+		}
+
+		bool BuildProgram()
+		{
+			const GLuint shader = CreateShader(gl_compute_shader);
+			GLint status = 0;
+
+			ShaderSource(shader, 1, &shader_source, nullptr);
+			CompileShader(shader);
+			GetShaderiv(shader, gl_compile_status, &status);
+
+			if (status == 0)
+			{
+				DeleteShader(shader);
+				return false;
+			}
+
+			program_ = CreateProgram();
+			AttachShader(program_, shader);
+			LinkProgram(program_);
+			DeleteShader(shader);
+			GetProgramiv(program_, gl_link_status, &status);
+
+			if (status == 0)
+			{
+				DeleteProgram(program_);
+				program_ = 0;
+				return false;
+			}
+
+			grid_size_ = GetUniformLocation(program_, "grid_size");
+			words_per_row_ = GetUniformLocation(program_, "words_per_row");
+			first_ = GetUniformLocation(program_, "first");
+			count_ = GetUniformLocation(program_, "count");
+			return true;
+		}
+
+		/* Rebinds buffer to its binding point with size bytes of data, or left undefined if data is nullptr. */
+		void Upload(Buffer buffer, std::size_t size, const void* data, GLenum usage)
+		{
+			BindBuffer(gl_shader_storage_buffer, buffers_[buffer]);
+			BufferData(gl_shader_storage_buffer, static_cast<GLsizeiptr>(std::max<std::size_t>(size, 4)), data, usage);
+			BindBufferBase(gl_shader_storage_buffer, static_cast<GLuint>(buffer), buffers_[buffer]);
+		}
+	};
+
+	GpuCaster::GpuCaster() : grid_()
+	{
+	}
+
+	GpuCaster::~GpuCaster()
+	{
+		if (device_ != nullptr)
+		{
+			device_->DeleteBuffers(buffer_count, device_->buffers_);
+			device_->DeleteProgram(device_->program_);
+		}
+	}
+
+	bool GpuCaster::Initialize(LoadProc load)
+	{
+		if (device_ != nullptr)
+		{
+			return true;
+		}
+
+		std::unique_ptr<Device> device = std::make_unique<Device>();
+
+		if (load == nullptr || !device->LoadAll(load))
+		{
+			return false;
+		}
+
+		GLint major = 0;
+		GLint minor = 0;
+		device->GetIntegerv(gl_major_version, &major);
+		device->GetIntegerv(gl_minor_version, &minor);
+
+		if (major < 4 || (major == 4 && minor < 3) || !device->BuildProgram())
+		{
+			return false;
+		}
+
+		device->GenBuffers(buffer_count, device->buffers_);
+		device_ = std::move(device);
+
+		if (grid_.words_ != nullptr)
+		{
+			SetGrid(grid_);
+		}
+
+		return true;
+	}
+
+	bool GpuCaster::IsAvailable() const
+	{
+		return device_ != nullptr;
+	}
+
+	const char* GpuCaster::GetDeviceName() const
+	{
+		if (device_ == nullptr)
+		{
+			return "";
+		}
+
+		const GLubyte* name = device_->GetString(gl_renderer);
+		return name != nullptr ? reinterpret_cast<const char*>(name) : "";
+	}
+
+	void GpuCaster::SetGrid(const GridView& grid)
+	{
+		grid_ = grid;
+
+		if (device_ != nullptr)
+		{
+			device_->Upload(words_buffer, static_cast<std::size_t>(grid.words_per_row_) * grid.height_ * sizeof(std::uint64_t), grid.words_, gl_static_draw);
+		}
+	}
+
+	std::size_t GpuCaster::CastBatch(Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, Span<RayHit> results, Kernel fallback)
+	{
+		if (device_ == nullptr)
+		{
+			return RayCaster(grid_).CastBatch(origins, directions, max_distance, results, fallback);
+		}
+
+		Device& device = *device_;
+		const std::size_t count = std::min({ origins.size(), directions.size(), results.size() });
+
+		// Setups are made on the CPU, with the very code the CPU kernels use,
+		// so the shader only has to step; they are kept to turn the hit
+		// distances it returns into points.
+		device.setups_.resize(count);
+		device.rays_.resize(count);
+		device.hits_.resize(count);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const RaySetup& setup = device.setups_[i] = MakeRaySetup(grid_, origins[i], directions[i], max_distance);
+			device.rays_[i] = { { setup.ray_length_.x, setup.ray_length_.y }, { setup.ray_step_size_.x, setup.ray_step_size_.y }, { setup.map_check_.x, setup.map_check_.y }, { setup.step_.x, setup.step_.y }, setup.limit_, setup.valid_ ? 1 : 0 };
+		}
+
+		device.Upload(rays_buffer, count * sizeof(GpuRay), device.rays_.data(), gl_stream_draw);
+		device.Upload(hits_buffer, count * sizeof(GpuHit), nullptr, gl_stream_read);
+
+		device.UseProgram(device.program_);
+		device.Uniform2i(device.grid_size_, grid_.width_, grid_.height_);
+		device.Uniform1ui(device.words_per_row_, static_cast<GLuint>(grid_.words_per_row_ * 2));
+		device.Uniform1ui(device.count_, static_cast<GLuint>(count));
+
+		constexpr std::size_t slice = static_cast<std::size_t>(group_size) * max_groups;
+
+		for (std::size_t first = 0; first < count; first += slice)
+		{
+			const std::size_t rays = std::min(slice, count - first);
+
+			device.Uniform1ui(device.first_, static_cast<GLuint>(first));
+			device.DispatchCompute(static_cast<GLuint>((rays + group_size - 1) / group_size), 1, 1);
+		}
+
+		device.Barrier(gl_buffer_update_barrier_bit);
+		device.BindBuffer(gl_shader_storage_buffer, device.buffers_[hits_buffer]);
+		device.GetBufferSubData(gl_shader_storage_buffer, 0, static_cast<GLsizeiptr>(count * sizeof(GpuHit)), device.hits_.data());
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const GpuHit& hit = device.hits_[i];
+			results[i] = hit.face_ != 0 ? MakeHit(device.setups_[i], { hit.cell_[0], hit.cell_[1] }, hit.distance_, static_cast<HitFace>(hit.face_)) : MakeMiss();
+		}
+
+		return count;
+	}
+} // namespace dda
\ No newline at end of file
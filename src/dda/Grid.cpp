@@ -0,0 +1,88 @@
+#include "dda/Grid.hpp"
+
+#include <algorithm>
+
+namespace dda
+{
+	Grid::Grid() : width_(0), height_(0), cell_size_(1), words_per_row_(0)
+	{
+	}
+
+	Grid::Grid(int width, int height, int cell_size) :
+		width_(width),
+		height_(height),
+		cell_size_(cell_size),
+		words_per_row_(WordsPerRow(width)),
+		words_(static_cast<std::size_t>(words_per_row_) * static_cast<std::size_t>(height), 0),
+		fine_blocks_(static_cast<std::size_t>(BlocksPerSide(width, fine_block_shift)) * BlocksPerSide(height, fine_block_shift), 0),
+		coarse_blocks_(static_cast<std::size_t>(BlocksPerSide(width, coarse_block_shift)) * BlocksPerSide(height, coarse_block_shift), 0),
+		dirty_(width, height)
+	{
+	}
+
+	int Grid::GetWidth() const
+	{
+		return width_;
+	}
+
+	int Grid::GetHeight() const
+	{
+		return height_;
+	}
+
+	int Grid::GetCellSize() const
+	{
+		return cell_size_;
+	}
+
+	bool Grid::IsWall(int x, int y) const
+	{
+		return GetView().IsWall(x, y);
+	}
+
+	void Grid::SetWall(int x, int y, bool wall)
+	{
+		if (x < 0 || x >= width_ || y < 0 || y >= height_)
+		{
+			return;
+		}
+
+		std::uint64_t& word = words_[static_cast<std::size_t>(y) * words_per_row_ + (x >> 6)];
+		const std::uint64_t bit = std::uint64_t{ 1 } << (x & 63);
+
+		if (((word & bit) != 0) == wall)
+		{
+			return;
+		}
+
+		word ^= bit;
+
+		const int delta = wall ? 1 : -1;
+		fine_blocks_[static_cast<std::size_t>(y >> fine_block_shift) * BlocksPerSide(width_, fine_block_shift) + (x >> fine_block_shift)] += delta;
+		coarse_blocks_[static_cast<std::size_t>(y >> coarse_block_shift) * BlocksPerSide(width_, coarse_block_shift) + (x >> coarse_block_shift)] += delta;
+		dirty_.MarkCell(x, y);
+	}
+
+	void Grid::Clear()
+	{
+		std::fill(words_.begin(), words_.end(), 0);
+		std::fill(fine_blocks_.begin(), fine_blocks_.end(), 0);
+		std::fill(coarse_blocks_.begin(), coarse_blocks_.end(), 0);
+		dirty_.MarkAll();
+	}
+
+	GridView Grid::GetView() const
+	{
+		return { words_.data(), words_per_row_, width_, height_, cell_size_, fine_blocks_.data(), coarse_blocks_.data(), nullptr };
+	}
+
+	const DirtyRegion& Grid::GetDirtyRegion() const
+	{
+		return dirty_;
+	}
+
+	void Grid::ClearDirtyRegion()
+	{
+		dirty_.Clear();
+	}
+} // namespace dda
\ No newline at end of file
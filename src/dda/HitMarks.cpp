@@ -0,0 +1,90 @@
+#include "dda/HitMarks.hpp"
+#include "dda/Grid.hpp"
+
+#include <algorithm>
+
+namespace dda
+{
+	HitMarks::HitMarks(int width, int height, std::size_t capacity) :
+		width_(width),
+		height_(height),
+		words_per_row_(WordsPerRow(width)),
+		capacity_(capacity),
+		words_(new std::atomic<std::uint64_t>[static_cast<std::size_t>(WordsPerRow(width)) * height]()),
+		cells_(new Vector2d<int>[capacity]),
+		count_(0)
+	{
+	}
+
+	bool HitMarks::Mark(int x, int y)
+	{
+		if (x < 0 || x >= width_ || y < 0 || y >= height_)
+		{
+			return false;
+		}
+
+		const std::uint64_t bit = std::uint64_t{ 1 } << (x & 63);
+		std::atomic<std::uint64_t>& word = words_[static_cast<std::size_t>(y) * words_per_row_ + (x >> 6)];
+
+		// Relaxed loads first: most marks of a frame land on cells already
+		// marked, and a read keeps the line shared between the threads.
+		if ((word.load(std::memory_order_relaxed) & bit) != 0 || (word.fetch_or(bit, std::memory_order_relaxed) & bit) != 0)
+		{
+			return false;
+		}
+
+		const std::size_t index = count_.fetch_add(1, std::memory_order_relaxed);
+
+		if (index < capacity_)
+		{
+			cells_[index] = { x, y };
+		}
+
+		return true;
+	}
+
+	void HitMarks::Mark(Span<const RayHit> hits)
+	{
+		for (const RayHit& hit : hits)
+		{
+			if (hit.hit_)
+			{
+				Mark(hit.cell_.x, hit.cell_.y);
+			}
+		}
+	}
+
+	bool HitMarks::IsMarked(int x, int y) const
+	{
+		if (x < 0 || x >= width_ || y < 0 || y >= height_)
+		{
+			return false;
+		}
+
+		return ((words_[static_cast<std::size_t>(y) * words_per_row_ + (x >> 6)].load(std::memory_order_relaxed) >> (x & 63)) & 1) != 0;
+	}
+
+	Span<const Vector2d<int>> HitMarks::GetCells() const
+	{
+		return { cells_.get(), std::min(count_.load(std::memory_order_relaxed), capacity_) };
+	}
+
+	void HitMarks::Clear()
+	{
+		const std::size_t count = count_.load(std::memory_order_relaxed);
+
+		if (count > capacity_)
+		{
+			std::fill_n(words_.get(), static_cast<std::size_t>(words_per_row_) * height_, 0);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				words_[static_cast<std::size_t>(cells_[i].y) * words_per_row_ + (cells_[i].x >> 6)].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		count_.store(0, std::memory_order_relaxed);
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "dda/JobPool.hpp"
+
+#include <algorithm>
+
+namespace dda
+{
+	JobPool::JobPool(unsigned thread_count) : generation_(0), stopping_(false), job_(nullptr), remaining_(0)
+	{
+		if (thread_count == 0)
+		{
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		for (unsigned i = 0; i < thread_count; ++i)
+		{
+			queues_.push_back(std::make_unique<WorkerQueue>());
+		}
+
+		for (unsigned i = 1; i < thread_count; ++i)
+		{
+			threads_.emplace_back(&JobPool::WorkerLoop, this, i);
+		}
+	}
+
+	JobPool::~JobPool()
+	{
+		{
+			const std::lock_guard<std::mutex> lock(wake_mutex_);
+			stopping_ = true;
+		}
+
+		wake_.notify_all();
+
+		for (std::thread& thread : threads_)
+		{
+			thread.join();
+		}
+	}
+
+	unsigned JobPool::GetThreadCount() const
+	{
+		return static_cast<unsigned>(queues_.size());
+	}
+
+	void JobPool::ParallelFor(std::size_t count, std::size_t chunk_size, const Job& job)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		chunk_size = std::max<std::size_t>(chunk_size, 1);
+
+		if (queues_.size() == 1 || count <= chunk_size)
+		{
+			job(0, count);
+			return;
+		}
+
+		const std::lock_guard<std::mutex> submit_lock(submit_mutex_);
+
+		const std::size_t chunks = (count + chunk_size - 1) / chunk_size;
+		job_ = &job;
+		remaining_.store(chunks, std::memory_order_release);
+
+		for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+		{
+			WorkerQueue& queue = *queues_[chunk % queues_.size()];
+			const std::lock_guard<std::mutex> lock(queue.mutex_);
+			queue.ranges_.push_back({ chunk * chunk_size, std::min(count, (chunk + 1) * chunk_size) });
+		}
+
+		{
+			const std::lock_guard<std::mutex> lock(wake_mutex_);
+			++generation_;
+		}
+
+		wake_.notify_all();
+
+		while (RunOne(0))
+		{
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex_);
+		done_.wait(lock, [this] { return remaining_.load(std::memory_order_acquire) == 0; });
+		job_ = nullptr;
+	}
+
+	void JobPool::WorkerLoop(std::size_t worker)
+	{
+		std::uint64_t seen = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(wake_mutex_);
+				wake_.wait(lock, [this, seen] { return stopping_ || generation_ != seen; });
+
+				if (stopping_)
+				{
+					return;
+				}
+
+				seen = generation_;
+			}
+
+			// Every chunk of a loop is queued before the workers are woken, so
+			// once nothing is left to pop or steal this loop needs no more help.
+			while (RunOne(worker))
+			{
+			}
+		}
+	}
+
+	bool JobPool::RunOne(std::size_t worker)
+	{
+		Range range;
+
+		if (!Pop(worker, range) && !Steal(worker, range))
+		{
+			return false;
+		}
+
+		(*job_)(range.begin_, range.end_);
+
+		if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			const std::lock_guard<std::mutex> lock(wake_mutex_);
+			done_.notify_all();
+		}
+
+		return true;
+	}
+
+	bool JobPool::Pop(std::size_t worker, Range& range)
+	{
+		WorkerQueue& queue = *queues_[worker];
+		const std::lock_guard<std::mutex> lock(queue.mutex_);
+
+		if (queue.ranges_.empty())
+		{
+			return false;
+		}
+
+		range = queue.ranges_.back();
+		queue.ranges_.pop_back();
+		return true;
+	}
+
+	bool JobPool::Steal(std::size_t thief, Range& range)
+	{
+		for (std::size_t offset = 1; offset < queues_.size(); ++offset)
+		{
+			WorkerQueue& queue = *queues_[(thief + offset) % queues_.size()];
+			const std::lock_guard<std::mutex> lock(queue.mutex_);
+
+			if (!queue.ranges_.empty())
+			{
+				range = queue.ranges_.front();
+				queue.ranges_.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "dda/Kernel.hpp"
+#include "Packet.hpp"
+
+namespace dda
+{
+	namespace
+	{
+		void TraverseScalar(const GridView& grid, const RaySetup* setups, std::size_t count, RayHit* results)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				results[i] = TraverseRay(grid, setups[i]);
+			}
+		}
+
+		void TraverseHierarchical(const GridView& grid, const RaySetup* setups, std::size_t count, RayHit* results)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				results[i] = TraverseRaySkipping(grid, setups[i]);
+			}
+		}
+
+		void TraverseDistanceField(const GridView& grid, const RaySetup* setups, std::size_t count, RayHit* results)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				results[i] = TraverseRayJumping(grid, setups[i]);
+			}
+		}
+
+		bool CpuSupports(Kernel kernel)
+		{
+#if defined(__x86_64__) || defined(__i386__)
+			switch (kernel)
+			{
+				case Kernel::sse2:
+					return __builtin_cpu_supports("sse2");
+				case Kernel::avx2:
+					return __builtin_cpu_supports("avx2");
+				case Kernel::avx512:
+					return __builtin_cpu_supports("avx512f");
+				default:
+					return kernel == Kernel::scalar || kernel == Kernel::hierarchical || kernel == Kernel::distance_field;
+			}
+#else
+			return kernel == Kernel::scalar || kernel == Kernel::hierarchical || kernel == Kernel::distance_field || kernel == Kernel::neon;
+#endif
+		}
+
+		PacketKernel GetBuiltinKernel(Kernel kernel)
+		{
+			switch (kernel)
+			{
+				case Kernel::scalar:
+					return &TraverseScalar;
+				case Kernel::hierarchical:
+					return &TraverseHierarchical;
+				case Kernel::distance_field:
+					return &TraverseDistanceField;
+				case Kernel::sse2:
+					return GetSse2Kernel();
+				case Kernel::avx2:
+					return GetAvx2Kernel();
+				case Kernel::avx512:
+					return GetAvx512Kernel();
+				case Kernel::neon:
+					return GetNeonKernel();
+				default:
+					return nullptr;
+			}
+		}
+
+		Kernel DetectBestKernel()
+		{
+			// sse2 has no gather, so its per-lane wall loads make it slower
+			// than scalar on most grids; it is only used when asked for.
+			constexpr Kernel preference[] = { Kernel::avx512, Kernel::avx2, Kernel::neon };
+
+			for (const Kernel kernel : preference)
+			{
+				if (IsKernelSupported(kernel))
+				{
+					return kernel;
+				}
+			}
+
+			return Kernel::scalar;
+		}
+	} // namespace
+
+	bool IsKernelSupported(Kernel kernel)
+	{
+		return GetBuiltinKernel(kernel) != nullptr && CpuSupports(kernel);
+	}
+
+	Kernel GetBestKernel()
+	{
+		static const Kernel best = DetectBestKernel();
+		return best;
+	}
+
+	const char* GetKernelName(Kernel kernel)
+	{
+		switch (kernel)
+		{
+			case Kernel::automatic:
+				return "automatic";
+			case Kernel::scalar:
+				return "scalar";
+			case Kernel::hierarchical:
+				return "hierarchical";
+			case Kernel::distance_field:
+				return "distance_field";
+			case Kernel::sse2:
+				return "sse2";
+			case Kernel::avx2:
+				return "avx2";
+			case Kernel::avx512:
+				return "avx512";
+			case Kernel::neon:
+				return "neon";
+		}
+
+		return "unknown";
+	}
+
+	PacketKernel ResolveKernel(Kernel kernel)
+	{
+		if (kernel == Kernel::automatic || !IsKernelSupported(kernel))
+		{
+			kernel = GetBestKernel();
+		}
+
+		return GetBuiltinKernel(kernel);
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "dda/MapFile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DDA_HAS_MMAP 1
+#endif
+
+namespace dda
+{
+	namespace
+	{
+		constexpr char map_magic[8] = { 'D', 'D', 'A', 'M', 'A', 'P', '\0', '\0' };
+		constexpr std::uint32_t map_byte_order = 0x01020304;
+		constexpr std::uint32_t map_version = 1;
+		constexpr std::uint64_t map_alignment = 64;
+
+		std::uint64_t AlignUp(std::uint64_t offset)
+		{
+			return (offset + map_alignment - 1) & ~(map_alignment - 1);
+		}
+
+		std::uint64_t GetFineCount(int width, int height)
+		{
+			return static_cast<std::uint64_t>(BlocksPerSide(width, fine_block_shift)) * BlocksPerSide(height, fine_block_shift);
+		}
+
+		std::uint64_t GetCoarseCount(int width, int height)
+		{
+			return static_cast<std::uint64_t>(BlocksPerSide(width, coarse_block_shift)) * BlocksPerSide(height, coarse_block_shift);
+		}
+
+		/* Fills in the section offsets and total size for a grid of the header's dimensions. */
+		void LayOut(MapHeader& header)
+		{
+			const std::uint64_t walls_size = static_cast<std::uint64_t>(header.words_per_row_) * header.height_ * sizeof(std::uint64_t);
+
+			header.walls_offset_ = AlignUp(sizeof(MapHeader));
+			header.fine_offset_ = AlignUp(header.walls_offset_ + walls_size);
+			header.coarse_offset_ = AlignUp(header.fine_offset_ + GetFineCount(header.width_, header.height_));
+			header.file_size_ = header.coarse_offset_ + GetCoarseCount(header.width_, header.height_) * sizeof(std::uint16_t);
+		}
+
+		bool IsValid(const MapHeader& header, std::size_t size)
+		{
+			if (std::memcmp(header.magic_, map_magic, sizeof(map_magic)) != 0 || header.byte_order_ != map_byte_order || header.version_ != map_version)
+			{
+				return false;
+			}
+
+			if (header.width_ <= 0 || header.height_ <= 0 || header.cell_size_ <= 0 || header.words_per_row_ != WordsPerRow(header.width_))
+			{
+				return false;
+			}
+
+			MapHeader expected = header;
+			LayOut(expected);
+
+			return header.walls_offset_ == expected.walls_offset_ && header.fine_offset_ == expected.fine_offset_ && header.coarse_offset_ == expected.coarse_offset_ && header.file_size_ == expected.file_size_ && header.file_size_ <= size;
+		}
+
+		bool WriteAt(std::FILE* file, std::uint64_t& position, std::uint64_t offset, const void* data, std::size_t size)
+		{
+			static const char padding[map_alignment] = {};
+
+			if (offset > position && std::fwrite(padding, 1, static_cast<std::size_t>(offset - position), file) != offset - position)
+			{
+				return false;
+			}
+
+			position = offset + size;
+			return size == 0 || std::fwrite(data, 1, size, file) == size;
+		}
+	} // namespace
+
+	MapFile::MapFile() : data_(nullptr), size_(0), mapped_(false), view_{ nullptr, 0, 0, 0, 1, nullptr, nullptr, nullptr }
+	{
+	}
+
+	MapFile::~MapFile()
+	{
+		Close();
+	}
+
+	bool MapFile::Open(const char* path)
+	{
+		Close();
+
+#ifdef DDA_HAS_MMAP
+		const int fd = open(path, O_RDONLY);
+
+		if (fd < 0)
+		{
+			return false;
+		}
+
+		struct stat status;
+
+		if (fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(MapHeader))
+		{
+			close(fd);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+
+		if (data == MAP_FAILED)
+		{
+			return false;
+		}
+
+		data_ = data;
+		size_ = static_cast<std::size_t>(status.st_size);
+		mapped_ = true;
+#else
+		std::FILE* file = std::fopen(path, "rb");
+
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		std::fseek(file, 0, SEEK_END);
+		const long length = std::ftell(file);
+		std::fseek(file, 0, SEEK_SET);
+
+		if (length < static_cast<long>(sizeof(MapHeader)) || (data_ = std::malloc(static_cast<std::size_t>(length))) == nullptr)
+		{
+			std::fclose(file);
+			return false;
+		}
+
+		size_ = static_cast<std::size_t>(length);
+		const bool read = std::fread(data_, 1, size_, file) == size_;
+		std::fclose(file);
+
+		if (!read)
+		{
+			Close();
+			return false;
+		}
+#endif
+
+		MapHeader header;
+		std::memcpy(&header, data_, sizeof(header));
+
+		if (!IsValid(header, size_))
+		{
+			Close();
+			return false;
+		}
+
+		const unsigned char* bytes = static_cast<const unsigned char*>(data_);
+		view_ = { reinterpret_cast<const std::uint64_t*>(bytes + header.walls_offset_), header.words_per_row_, header.width_, header.height_, header.cell_size_, bytes + header.fine_offset_, reinterpret_cast<const std::uint16_t*>(bytes + header.coarse_offset_), nullptr };
+		return true;
+	}
+
+	void MapFile::Close()
+	{
+		if (data_ != nullptr)
+		{
+#ifdef DDA_HAS_MMAP
+			if (mapped_)
+			{
+				munmap(data_, size_);
+			}
+#else
+			std::free(data_);
+#endif
+		}
+
+		data_ = nullptr;
+		size_ = 0;
+		mapped_ = false;
+		view_ = { nullptr, 0, 0, 0, 1, nullptr, nullptr, nullptr };
+	}
+
+	bool MapFile::IsOpen() const
+	{
+		return data_ != nullptr;
+	}
+
+	GridView MapFile::GetView() const
+	{
+		return view_;
+	}
+
+	bool SaveMap(const char* path, const GridView& grid)
+	{
+		MapHeader header = {};
+		std::memcpy(header.magic_, map_magic, sizeof(map_magic));
+		header.byte_order_ = map_byte_order;
+		header.version_ = map_version;
+		header.width_ = grid.width_;
+		header.height_ = grid.height_;
+		header.cell_size_ = grid.cell_size_;
+		header.words_per_row_ = grid.words_per_row_;
+		LayOut(header);
+
+		const std::size_t word_count = static_cast<std::size_t>(grid.words_per_row_) * grid.height_;
+		const std::size_t fine_count = static_cast<std::size_t>(GetFineCount(grid.width_, grid.height_));
+		const std::size_t coarse_count = static_cast<std::size_t>(GetCoarseCount(grid.width_, grid.height_));
+
+		std::vector<std::uint8_t> fine_blocks;
+		std::vector<std::uint16_t> coarse_blocks;
+		const std::uint8_t* fine = grid.fine_blocks_;
+		const std::uint16_t* coarse = grid.coarse_blocks_;
+
+		if (fine == nullptr || coarse == nullptr)
+		{
+			// Fine blocks are 8 bits of one word and coarse blocks a whole
+			// word of each row they cover, so popcounts build both.
+			fine_blocks.assign(fine_count, 0);
+			coarse_blocks.assign(coarse_count, 0);
+
+			for (int y = 0; y < grid.height_; ++y)
+			{
+				for (int word = 0; word < grid.words_per_row_; ++word)
+				{
+					const std::uint64_t bits = grid.words_[static_cast<std::size_t>(y) * grid.words_per_row_ + word];
+
+					if (bits == 0)
+					{
+						continue;
+					}
+
+					coarse_blocks[static_cast<std::size_t>(y >> coarse_block_shift) * BlocksPerSide(grid.width_, coarse_block_shift) + word] += static_cast<std::uint16_t>(__builtin_popcountll(bits));
+
+					for (int byte = 0; byte < 8 && word * 8 + byte < BlocksPerSide(grid.width_, fine_block_shift); ++byte)
+					{
+						fine_blocks[static_cast<std::size_t>(y >> fine_block_shift) * BlocksPerSide(grid.width_, fine_block_shift) + word * 8 + byte] += static_cast<std::uint8_t>(__builtin_popcountll((bits >> (byte * 8)) & 0xff));
+					}
+				}
+			}
+
+			fine = fine_blocks.data();
+			coarse = coarse_blocks.data();
+		}
+
+		std::FILE* file = std::fopen(path, "wb");
+
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		std::uint64_t position = 0;
+		const bool written = WriteAt(file, position, 0, &header, sizeof(header)) && WriteAt(file, position, header.walls_offset_, grid.words_, word_count * sizeof(std::uint64_t)) && WriteAt(file, position, header.fine_offset_, fine, fine_count) && WriteAt(file, position, header.coarse_offset_, coarse, coarse_count * sizeof(std::uint16_t));
+
+		return std::fclose(file) == 0 && written;
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef DDA_PACKET_HPP
+#define DDA_PACKET_HPP
+
+#include "dda/Kernel.hpp"
+#include "Traversal.hpp"
+
+#include <cstddef>
+
+namespace dda
+{
+	/* Traverses setups[0, count) into results[0, count). */
+	using PacketKernel = void (*)(const GridView& grid, const RaySetup* setups, std::size_t count, RayHit* results);
+
+	/* Returns the traversal for kernel, or nullptr if it is not built in or not supported by this CPU. */
+	PacketKernel ResolveKernel(Kernel kernel);
+
+	/* Each returns nullptr if its instruction set was not enabled when the library was built. */
+	PacketKernel GetSse2Kernel();
+
+	PacketKernel GetAvx2Kernel();
+
+	PacketKernel GetAvx512Kernel();
+
+	PacketKernel GetNeonKernel();
+} // namespace dda
+
+#endif
\ No newline at end of file
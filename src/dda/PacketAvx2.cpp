@@ -0,0 +1,98 @@
+#include "Packet.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// Only what follows is built for AVX2, see PacketTraversal.hpp; the
+// file as a whole stays at the baseline.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "PacketTraversal.hpp"
+
+namespace dda
+{
+	namespace
+	{
+		struct Avx2
+		{
+			using F = __m256;
+			using I = __m256i;
+			using M = __m256i;
+
+			static constexpr int lanes = 8;
+
+			static F LoadF(const float* p) { return _mm256_load_ps(p); }
+			static I LoadI(const int* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+			static void StoreF(float* p, F v) { _mm256_store_ps(p, v); }
+			static void StoreI(int* p, I v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+			static void StoreM(int* p, M m) { StoreI(p, m); }
+			static F SetF(float v) { return _mm256_set1_ps(v); }
+			static I SetI(int v) { return _mm256_set1_epi32(v); }
+			static F AddF(F a, F b) { return _mm256_add_ps(a, b); }
+			static I AddI(I a, I b) { return _mm256_add_epi32(a, b); }
+
+			static M MaskFromI(I v) { return v; }
+			static M NoneM() { return _mm256_setzero_si256(); }
+			static bool Any(M m) { return !_mm256_testz_si256(m, m); }
+			static M AndM(M a, M b) { return _mm256_and_si256(a, b); }
+			static M AndNotM(M a, M b) { return _mm256_andnot_si256(b, a); }
+			static M OrM(M a, M b) { return _mm256_or_si256(a, b); }
+			static M LessF(F a, F b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+			static M LessEqualF(F a, F b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+			static F SelectF(M m, F a, F b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(m)); }
+			static I SelectI(M m, I a, I b) { return _mm256_blendv_epi8(b, a, m); }
+			static M SelectM(M m, M a, M b) { return SelectI(m, a, b); }
+
+			static M InBounds(I x, I y, int width, int height)
+			{
+				const __m256i minus_one = _mm256_set1_epi32(-1);
+				const __m256i in_x = _mm256_and_si256(_mm256_cmpgt_epi32(x, minus_one), _mm256_cmpgt_epi32(_mm256_set1_epi32(width), x));
+				const __m256i in_y = _mm256_and_si256(_mm256_cmpgt_epi32(y, minus_one), _mm256_cmpgt_epi32(_mm256_set1_epi32(height), y));
+				return _mm256_and_si256(in_x, in_y);
+			}
+
+			/*
+			 * Gathers the 32-bit half of each row word that holds the cell. The
+			 * words are little-endian, so bit (x % 32) of half-word (x / 32)
+			 * is cell x.
+			 */
+			static M GatherWalls(const GridView& grid, M m, I x, I y)
+			{
+				const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(grid.words_per_row_ * 2)), _mm256_srli_epi32(x, 5));
+				const __m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(grid.words_), index, m, 4);
+				const __m256i bits = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(x, _mm256_set1_epi32(31))), _mm256_set1_epi32(1));
+				return _mm256_andnot_si256(_mm256_cmpeq_epi32(bits, _mm256_setzero_si256()), m);
+			}
+		};
+	} // namespace
+
+	const PacketKernel avx2_kernel = &TraversePackets<Avx2>;
+} // namespace dda
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace dda
+{
+	PacketKernel GetAvx2Kernel()
+	{
+		return avx2_kernel;
+	}
+} // namespace dda
+#else
+namespace dda
+{
+	PacketKernel GetAvx2Kernel()
+	{
+		return nullptr;
+	}
+} // namespace dda
+#endif
\ No newline at end of file
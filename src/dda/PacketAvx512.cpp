@@ -0,0 +1,91 @@
+#include "Packet.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// Only what follows is built for AVX-512, see PacketTraversal.hpp; the
+// file as a whole stays at the baseline.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+#include "PacketTraversal.hpp"
+
+namespace dda
+{
+	namespace
+	{
+		struct Avx512
+		{
+			using F = __m512;
+			using I = __m512i;
+			using M = __mmask16;
+
+			static constexpr int lanes = 16;
+
+			static F LoadF(const float* p) { return _mm512_load_ps(p); }
+			static I LoadI(const int* p) { return _mm512_load_si512(p); }
+			static void StoreF(float* p, F v) { _mm512_store_ps(p, v); }
+			static void StoreI(int* p, I v) { _mm512_store_si512(p, v); }
+			static void StoreM(int* p, M m) { StoreI(p, _mm512_maskz_mov_epi32(m, _mm512_set1_epi32(-1))); }
+			static F SetF(float v) { return _mm512_set1_ps(v); }
+			static I SetI(int v) { return _mm512_set1_epi32(v); }
+			static F AddF(F a, F b) { return _mm512_add_ps(a, b); }
+			static I AddI(I a, I b) { return _mm512_add_epi32(a, b); }
+
+			static M MaskFromI(I v) { return _mm512_test_epi32_mask(v, v); }
+			static M NoneM() { return 0; }
+			static bool Any(M m) { return m != 0; }
+			static M AndM(M a, M b) { return static_cast<M>(a & b); }
+			static M AndNotM(M a, M b) { return static_cast<M>(a & ~b); }
+			static M OrM(M a, M b) { return static_cast<M>(a | b); }
+			static M LessF(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+			static M LessEqualF(F a, F b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+			static F SelectF(M m, F a, F b) { return _mm512_mask_blend_ps(m, b, a); }
+			static I SelectI(M m, I a, I b) { return _mm512_mask_blend_epi32(m, b, a); }
+			static M SelectM(M m, M a, M b) { return static_cast<M>((m & a) | (~m & b)); }
+
+			static M InBounds(I x, I y, int width, int height)
+			{
+				return static_cast<M>(_mm512_cmplt_epu32_mask(x, _mm512_set1_epi32(width)) & _mm512_cmplt_epu32_mask(y, _mm512_set1_epi32(height)));
+			}
+
+			/* Same half-word gather as the AVX2 kernel. */
+			static M GatherWalls(const GridView& grid, M m, I x, I y)
+			{
+				const __m512i index = _mm512_add_epi32(_mm512_mullo_epi32(y, _mm512_set1_epi32(grid.words_per_row_ * 2)), _mm512_maskz_srli_epi32(m, x, 5));
+				const __m512i words = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, index, grid.words_, 4);
+				const __m512i bits = _mm512_maskz_srlv_epi32(m, words, _mm512_and_si512(x, _mm512_set1_epi32(31)));
+				return _mm512_mask_test_epi32_mask(m, bits, _mm512_set1_epi32(1));
+			}
+		};
+	} // namespace
+
+	const PacketKernel avx512_kernel = &TraversePackets<Avx512>;
+} // namespace dda
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace dda
+{
+	PacketKernel GetAvx512Kernel()
+	{
+		return avx512_kernel;
+	}
+} // namespace dda
+#else
+namespace dda
+{
+	PacketKernel GetAvx512Kernel()
+	{
+		return nullptr;
+	}
+} // namespace dda
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "Packet.hpp"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+// NEON is the baseline on AArch64, so no target pragma is needed.
+#include "PacketTraversal.hpp"
+#endif
+
+namespace dda
+{
+#if defined(__aarch64__) && defined(__ARM_NEON)
+	namespace
+	{
+		struct Neon
+		{
+			using F = float32x4_t;
+			using I = int32x4_t;
+			using M = uint32x4_t;
+
+			static constexpr int lanes = 4;
+
+			static F LoadF(const float* p) { return vld1q_f32(p); }
+			static I LoadI(const int* p) { return vld1q_s32(p); }
+			static void StoreF(float* p, F v) { vst1q_f32(p, v); }
+			static void StoreI(int* p, I v) { vst1q_s32(p, v); }
+			static void StoreM(int* p, M m) { StoreI(p, vreinterpretq_s32_u32(m)); }
+			static F SetF(float v) { return vdupq_n_f32(v); }
+			static I SetI(int v) { return vdupq_n_s32(v); }
+			static F AddF(F a, F b) { return vaddq_f32(a, b); }
+			static I AddI(I a, I b) { return vaddq_s32(a, b); }
+
+			static M MaskFromI(I v) { return vreinterpretq_u32_s32(v); }
+			static M NoneM() { return vdupq_n_u32(0); }
+			static bool Any(M m) { return vmaxvq_u32(m) != 0; }
+			static M AndM(M a, M b) { return vandq_u32(a, b); }
+			static M AndNotM(M a, M b) { return vbicq_u32(a, b); }
+			static M OrM(M a, M b) { return vorrq_u32(a, b); }
+			static M LessF(F a, F b) { return vcltq_f32(a, b); }
+			static M LessEqualF(F a, F b) { return vcleq_f32(a, b); }
+			static F SelectF(M m, F a, F b) { return vbslq_f32(m, a, b); }
+			static I SelectI(M m, I a, I b) { return vbslq_s32(m, a, b); }
+			static M SelectM(M m, M a, M b) { return vbslq_u32(m, a, b); }
+
+			static M InBounds(I x, I y, int width, int height)
+			{
+				const uint32x4_t in_x = vcltq_u32(vreinterpretq_u32_s32(x), vdupq_n_u32(static_cast<std::uint32_t>(width)));
+				const uint32x4_t in_y = vcltq_u32(vreinterpretq_u32_s32(y), vdupq_n_u32(static_cast<std::uint32_t>(height)));
+				return vandq_u32(in_x, in_y);
+			}
+
+			static M GatherWalls(const GridView& grid, M m, I x, I y)
+			{
+				int mask[lanes];
+				int xs[lanes];
+				int ys[lanes];
+				int walls[lanes];
+				StoreM(mask, m);
+				StoreI(xs, x);
+				StoreI(ys, y);
+				GatherWallsScalar<lanes>(grid, mask, xs, ys, walls);
+				return MaskFromI(LoadI(walls));
+			}
+		};
+	} // namespace
+
+	PacketKernel GetNeonKernel()
+	{
+		return &TraversePackets<Neon>;
+	}
+#else
+	PacketKernel GetNeonKernel()
+	{
+		return nullptr;
+	}
+#endif
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "Packet.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+
+// Only what follows is built for SSE2, see PacketTraversal.hpp; the
+// file as a whole stays at the baseline.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#include "PacketTraversal.hpp"
+
+namespace dda
+{
+	namespace
+	{
+		struct Sse2
+		{
+			using F = __m128;
+			using I = __m128i;
+			using M = __m128i;
+
+			static constexpr int lanes = 4;
+
+			static F LoadF(const float* p) { return _mm_load_ps(p); }
+			static I LoadI(const int* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+			static void StoreF(float* p, F v) { _mm_store_ps(p, v); }
+			static void StoreI(int* p, I v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+			static void StoreM(int* p, M m) { StoreI(p, m); }
+			static F SetF(float v) { return _mm_set1_ps(v); }
+			static I SetI(int v) { return _mm_set1_epi32(v); }
+			static F AddF(F a, F b) { return _mm_add_ps(a, b); }
+			static I AddI(I a, I b) { return _mm_add_epi32(a, b); }
+
+			static M MaskFromI(I v) { return v; }
+			static M NoneM() { return _mm_setzero_si128(); }
+			static bool Any(M m) { return _mm_movemask_epi8(m) != 0; }
+			static M AndM(M a, M b) { return _mm_and_si128(a, b); }
+			static M AndNotM(M a, M b) { return _mm_andnot_si128(b, a); }
+			static M OrM(M a, M b) { return _mm_or_si128(a, b); }
+			static M LessF(F a, F b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+			static M LessEqualF(F a, F b) { return _mm_castps_si128(_mm_cmple_ps(a, b)); }
+
+			static F SelectF(M m, F a, F b)
+			{
+				const __m128 mf = _mm_castsi128_ps(m);
+				return _mm_or_ps(_mm_and_ps(mf, a), _mm_andnot_ps(mf, b));
+			}
+
+			static I SelectI(M m, I a, I b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+			static M SelectM(M m, M a, M b) { return SelectI(m, a, b); }
+
+			static M InBounds(I x, I y, int width, int height)
+			{
+				const __m128i minus_one = _mm_set1_epi32(-1);
+				const __m128i in_x = _mm_and_si128(_mm_cmpgt_epi32(x, minus_one), _mm_cmpgt_epi32(_mm_set1_epi32(width), x));
+				const __m128i in_y = _mm_and_si128(_mm_cmpgt_epi32(y, minus_one), _mm_cmpgt_epi32(_mm_set1_epi32(height), y));
+				return _mm_and_si128(in_x, in_y);
+			}
+
+			static M GatherWalls(const GridView& grid, M m, I x, I y)
+			{
+				alignas(16) int mask[lanes];
+				alignas(16) int xs[lanes];
+				alignas(16) int ys[lanes];
+				alignas(16) int walls[lanes];
+				StoreI(mask, m);
+				StoreI(xs, x);
+				StoreI(ys, y);
+				GatherWallsScalar<lanes>(grid, mask, xs, ys, walls);
+				return LoadI(walls);
+			}
+		};
+	} // namespace
+
+	const PacketKernel sse2_kernel = &TraversePackets<Sse2>;
+} // namespace dda
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+
+namespace dda
+{
+	PacketKernel GetSse2Kernel()
+	{
+		return sse2_kernel;
+	}
+} // namespace dda
+#else
+namespace dda
+{
+	PacketKernel GetSse2Kernel()
+	{
+		return nullptr;
+	}
+} // namespace dda
+#endif
\ No newline at end of file
@@ -0,0 +1,184 @@
+#ifndef DDA_PACKET_TRAVERSAL_HPP
+#define DDA_PACKET_TRAVERSAL_HPP
+
+#include "Packet.hpp"
+
+/*
+ * The lockstep traversal, included only by the Packet*.cpp files and only
+ * once they have switched the instruction set with a target pragma, so
+ * that each instantiation is built for its own. Everything here has
+ * internal linkage: code built for one instruction set must never be a
+ * copy the linker can pick for the others, which is why the helpers of
+ * Traversal.hpp and Grid.hpp are included before the pragma and stay at
+ * the baseline.
+ */
+namespace dda
+{
+	namespace
+	{
+		/* Wall lookup for instruction sets without a gather: lanes with mask[lane] == 0 read nothing. */
+		template <int lanes>
+		void GatherWallsScalar(const GridView& grid, const int* mask, const int* x, const int* y, int* walls)
+		{
+			for (int lane = 0; lane < lanes; ++lane)
+			{
+				walls[lane] = (mask[lane] != 0 && grid.IsWall(x[lane], y[lane])) ? -1 : 0;
+			}
+		}
+
+		/*
+		 * Lockstep DDA over Simd::lanes rays at a time. Each iteration advances
+		 * every live lane by one cell along the axis with the shorter ray length,
+		 * chosen with a branchless select, then looks the new cells up with a
+		 * masked gather. A lane retires on a wall hit or once past its limit,
+		 * and is refilled with the next pending ray so that short rays do not
+		 * leave the packet idling behind long ones. The arithmetic is the same
+		 * as TraverseRay, so results match the scalar path exactly.
+		 *
+		 * Simd provides the vector types F, I and M (mask) and the operations
+		 * used below; see the Packet*.cpp files.
+		 */
+		template <typename Simd>
+		void TraversePackets(const GridView& grid, const RaySetup* setups, std::size_t count, RayHit* results)
+		{
+			using F = typename Simd::F;
+			using I = typename Simd::I;
+			using M = typename Simd::M;
+
+			constexpr int lanes = Simd::lanes;
+
+			alignas(64) float ray_length_x[lanes];
+			alignas(64) float ray_length_y[lanes];
+			alignas(64) float ray_step_size_x[lanes];
+			alignas(64) float ray_step_size_y[lanes];
+			alignas(64) float limit[lanes];
+			alignas(64) int map_check_x[lanes];
+			alignas(64) int map_check_y[lanes];
+			alignas(64) int step_x[lanes];
+			alignas(64) int step_y[lanes];
+			alignas(64) int live[lanes];
+			alignas(64) std::size_t ray[lanes];
+
+			alignas(64) float lane_distance[lanes];
+			alignas(64) int lane_on_x[lanes];
+			alignas(64) int lane_wall[lanes];
+			alignas(64) int lane_retired[lanes];
+
+			std::size_t next = 0;
+
+			const auto refill = [&](int lane)
+			{
+				while (next < count && !setups[next].valid_)
+				{
+					results[next++] = MakeMiss();
+				}
+
+				if (next == count)
+				{
+					ray_length_x[lane] = 0.0f;
+					ray_length_y[lane] = 0.0f;
+					ray_step_size_x[lane] = 0.0f;
+					ray_step_size_y[lane] = 0.0f;
+					limit[lane] = 0.0f;
+					map_check_x[lane] = -1;
+					map_check_y[lane] = -1;
+					step_x[lane] = 0;
+					step_y[lane] = 0;
+					live[lane] = 0;
+					return;
+				}
+
+				const RaySetup& setup = setups[next];
+				ray_length_x[lane] = setup.ray_length_.x;
+				ray_length_y[lane] = setup.ray_length_.y;
+				ray_step_size_x[lane] = setup.ray_step_size_.x;
+				ray_step_size_y[lane] = setup.ray_step_size_.y;
+				limit[lane] = setup.limit_;
+				map_check_x[lane] = setup.map_check_.x;
+				map_check_y[lane] = setup.map_check_.y;
+				step_x[lane] = setup.step_.x;
+				step_y[lane] = setup.step_.y;
+				live[lane] = -1;
+				ray[lane] = next++;
+			};
+
+			for (int lane = 0; lane < lanes; ++lane)
+			{
+				refill(lane);
+			}
+
+			F length_x = Simd::LoadF(ray_length_x);
+			F length_y = Simd::LoadF(ray_length_y);
+			F step_size_x = Simd::LoadF(ray_step_size_x);
+			F step_size_y = Simd::LoadF(ray_step_size_y);
+			F max = Simd::LoadF(limit);
+			I check_x = Simd::LoadI(map_check_x);
+			I check_y = Simd::LoadI(map_check_y);
+			I sign_x = Simd::LoadI(step_x);
+			I sign_y = Simd::LoadI(step_y);
+			M active = Simd::MaskFromI(Simd::LoadI(live));
+
+			while (Simd::Any(active))
+			{
+				const M on_x = Simd::LessF(length_x, length_y);
+				const F distance = Simd::SelectF(on_x, length_x, length_y);
+
+				check_x = Simd::AddI(check_x, Simd::SelectI(on_x, sign_x, Simd::SetI(0)));
+				check_y = Simd::AddI(check_y, Simd::SelectI(on_x, Simd::SetI(0), sign_y));
+				length_x = Simd::AddF(length_x, Simd::SelectF(on_x, step_size_x, Simd::SetF(0.0f)));
+				length_y = Simd::AddF(length_y, Simd::SelectF(on_x, Simd::SetF(0.0f), step_size_y));
+
+				const M in_range = Simd::AndM(active, Simd::LessEqualF(distance, max));
+				const M walls = Simd::GatherWalls(grid, Simd::AndM(in_range, Simd::InBounds(check_x, check_y, grid.width_, grid.height_)), check_x, check_y);
+				const M retired = Simd::OrM(Simd::AndNotM(active, in_range), walls);
+
+				if (!Simd::Any(retired))
+				{
+					continue;
+				}
+
+				Simd::StoreF(ray_length_x, length_x);
+				Simd::StoreF(ray_length_y, length_y);
+				Simd::StoreI(map_check_x, check_x);
+				Simd::StoreI(map_check_y, check_y);
+				Simd::StoreF(lane_distance, distance);
+				Simd::StoreM(lane_on_x, on_x);
+				Simd::StoreM(lane_wall, walls);
+				Simd::StoreM(lane_retired, retired);
+
+				for (int lane = 0; lane < lanes; ++lane)
+				{
+					if (lane_retired[lane] == 0)
+					{
+						continue;
+					}
+
+					if (lane_wall[lane] != 0)
+					{
+						const HitFace face = lane_on_x[lane] != 0 ? (step_x[lane] > 0 ? HitFace::west : HitFace::east) : (step_y[lane] > 0 ? HitFace::north : HitFace::south);
+						results[ray[lane]] = MakeHit(setups[ray[lane]], { map_check_x[lane], map_check_y[lane] }, lane_distance[lane], face);
+					}
+					else
+					{
+						results[ray[lane]] = MakeMiss();
+					}
+
+					refill(lane);
+				}
+
+				length_x = Simd::LoadF(ray_length_x);
+				length_y = Simd::LoadF(ray_length_y);
+				step_size_x = Simd::LoadF(ray_step_size_x);
+				step_size_y = Simd::LoadF(ray_step_size_y);
+				max = Simd::LoadF(limit);
+				check_x = Simd::LoadI(map_check_x);
+				check_y = Simd::LoadI(map_check_y);
+				sign_x = Simd::LoadI(step_x);
+				sign_y = Simd::LoadI(step_y);
+				active = Simd::MaskFromI(Simd::LoadI(live));
+			}
+		}
+	} // namespace
+} // namespace dda
+
+#endif
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "dda/Queries.hpp"
+#include "Packet.hpp"
+#include "Traversal.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dda
+{
+	namespace
+	{
+		Vector2d<int> GetCell(const GridView& grid, const Vector2d<float>& point)
+		{
+			const float cell_size = static_cast<float>(grid.cell_size_);
+			return { static_cast<int>(std::floor(point.x / cell_size)), static_cast<int>(std::floor(point.y / cell_size)) };
+		}
+
+		/* Cell source for TraverseRay that walks through every cell. */
+		struct NoWalls
+		{
+			bool IsWall(int, int) const
+			{
+				return false;
+			}
+		};
+
+		/* TraverseRay visitor; a ray ending exactly on the grid's edge enters one cell outside, which is left out. */
+		struct AppendCells
+		{
+			const GridView& grid_;
+			std::vector<Vector2d<int>>& cells_;
+
+			void operator()(const Vector2d<int>& cell)
+			{
+				if (grid_.Contains(cell.x, cell.y))
+				{
+					cells_.push_back(cell);
+				}
+			}
+		};
+
+		bool ReachesTarget(const RayHit& hit, const Vector2d<int>& target_cell)
+		{
+			return !hit.hit_ || (hit.cell_.x == target_cell.x && hit.cell_.y == target_cell.y);
+		}
+
+		/* Many-target line of sight with the scratch supplied by the caller; angles and order are as long as targets and visible. */
+		void TestTargets(const GridView& grid, const Vector2d<float>& origin, Span<const Vector2d<float>> targets, Span<std::uint8_t> visible, Kernel kernel, Span<float> angles, Span<std::size_t> order)
+		{
+			const std::size_t count = targets.size();
+			const OriginSetup origin_setup = MakeOriginSetup(grid, origin);
+			const PacketKernel traverse = ResolveKernel(kernel);
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				angles[i] = std::atan2(targets[i].y - origin.y, targets[i].x - origin.x);
+				order[i] = i;
+			}
+
+			std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return angles[a] < angles[b]; });
+
+			constexpr std::size_t chunk_size = 256;
+			RaySetup setups[chunk_size];
+			RayHit results[chunk_size];
+
+			for (std::size_t begin = 0; begin < count; begin += chunk_size)
+			{
+				const std::size_t end = std::min(begin + chunk_size, count);
+
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					const Vector2d<float>& target = targets[order[i]];
+					const Vector2d<float> delta = { target.x - origin.x, target.y - origin.y };
+					const float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+
+					// A target at the origin gets an invalid setup, which misses.
+					setups[i - begin] = length == 0.0f ? RaySetup{} : MakeRaySetup(grid, origin_setup, { delta.x / length, delta.y / length }, length);
+				}
+
+				traverse(grid, setups, end - begin, results);
+
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					visible[order[i]] = ReachesTarget(results[i - begin], GetCell(grid, targets[order[i]])) ? 1 : 0;
+				}
+			}
+		}
+	} // namespace
+
+	bool HasLineOfSight(const GridView& grid, const Vector2d<float>& from, const Vector2d<float>& to)
+	{
+		const Vector2d<float> delta = { to.x - from.x, to.y - from.y };
+		const float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+
+		if (length == 0.0f)
+		{
+			return true;
+		}
+
+		return ReachesTarget(TraverseRaySkipping(grid, MakeRaySetup(grid, from, delta, length)), GetCell(grid, to));
+	}
+
+	std::size_t HasLineOfSight(const GridView& grid, const Vector2d<float>& origin, Span<const Vector2d<float>> targets, Span<std::uint8_t> visible, Kernel kernel)
+	{
+		const std::size_t count = std::min(targets.size(), visible.size());
+
+		std::vector<float> angles(count);
+		std::vector<std::size_t> order(count);
+
+		TestTargets(grid, origin, targets.subspan(0, count), visible.subspan(0, count), kernel, angles, order);
+		return count;
+	}
+
+	Span<std::uint8_t> HasLineOfSight(Arena& arena, const GridView& grid, const Vector2d<float>& origin, Span<const Vector2d<float>> targets, Kernel kernel)
+	{
+		const Span<std::uint8_t> visible = arena.Allocate<std::uint8_t>(targets.size());
+		const Span<std::size_t> order = arena.Allocate<std::size_t>(targets.size());
+		const Span<float> angles = arena.Allocate<float>(targets.size());
+
+		TestTargets(grid, origin, targets, visible, kernel, angles, order);
+
+		// The scratch was allocated last, so it goes straight back.
+		arena.Shrink(angles, 0);
+		arena.Shrink(order, 0);
+		return visible;
+	}
+
+	void FindCellsInRadius(const GridView& grid, const Vector2d<float>& center, float radius, std::vector<Vector2d<int>>& cells, bool walls_only)
+	{
+		cells.clear();
+
+		if (!(radius >= 0.0f))
+		{
+			return;
+		}
+
+		const float cell_size = static_cast<float>(grid.cell_size_);
+		const int top = std::max(static_cast<int>(std::floor((center.y - radius) / cell_size)), 0);
+		const int bottom = std::min(static_cast<int>(std::floor((center.y + radius) / cell_size)), grid.height_ - 1);
+
+		for (int y = top; y <= bottom; ++y)
+		{
+			// A cell overlaps the circle if its nearest point does; along a row
+			// the vertical part of that distance is the same for every cell.
+			const float dy = std::max({ y * cell_size - center.y, center.y - (y + 1) * cell_size, 0.0f });
+			const float half_width = std::sqrt(std::max(radius * radius - dy * dy, 0.0f));
+			const int left = std::max(static_cast<int>(std::floor((center.x - half_width) / cell_size)), 0);
+			const int right = std::min(static_cast<int>(std::floor((center.x + half_width) / cell_size)), grid.width_ - 1);
+
+			if (left > right)
+			{
+				continue;
+			}
+
+			if (!walls_only)
+			{
+				for (int x = left; x <= right; ++x)
+				{
+					cells.push_back({ x, y });
+				}
+
+				continue;
+			}
+
+			const std::uint64_t* row = grid.words_ + static_cast<std::size_t>(y) * grid.words_per_row_;
+
+			for (int word = left >> 6; word <= right >> 6; ++word)
+			{
+				std::uint64_t bits = row[word];
+
+				if (word == left >> 6)
+				{
+					bits &= ~std::uint64_t{ 0 } << (left & 63);
+				}
+
+				if (word == right >> 6)
+				{
+					bits &= ~std::uint64_t{ 0 } >> (63 - (right & 63));
+				}
+
+				while (bits != 0)
+				{
+					cells.push_back({ word * 64 + __builtin_ctzll(bits), y });
+					bits &= bits - 1;
+				}
+			}
+		}
+	}
+
+	void FindCellsOnSegment(const GridView& grid, const Vector2d<float>& from, const Vector2d<float>& to, std::vector<Vector2d<int>>& cells)
+	{
+		cells.clear();
+
+		const Vector2d<int> first = GetCell(grid, from);
+
+		if (grid.Contains(first.x, first.y))
+		{
+			cells.push_back(first);
+		}
+
+		const Vector2d<float> delta = { to.x - from.x, to.y - from.y };
+		const float length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+
+		if (length == 0.0f)
+		{
+			return;
+		}
+
+		NoWalls no_walls;
+		TraverseRay(no_walls, MakeRaySetup(grid, from, delta, length), AppendCells{ grid, cells });
+
+		// With to exactly on a cell boundary, rounding can stop the walk just
+		// short of its cell.
+		const Vector2d<int> last = GetCell(grid, to);
+
+		if (grid.Contains(last.x, last.y) && (cells.empty() || cells.back().x != last.x || cells.back().y != last.y))
+		{
+			cells.push_back(last);
+		}
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "dda/RayCaster.hpp"
+#include "Packet.hpp"
+#include "Traversal.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace dda
+{
+	namespace
+	{
+		/* TraverseRay visitor writing into a fixed buffer; cells past its end or outside the grid are dropped. */
+		struct RecordCells
+		{
+			const GridView& grid_;
+			Span<Vector2d<int>> cells_;
+			std::size_t& count_;
+
+			void operator()(const Vector2d<int>& cell)
+			{
+				if (count_ < cells_.size() && grid_.Contains(cell.x, cell.y))
+				{
+					cells_[count_++] = cell;
+				}
+			}
+		};
+
+		/* Cells a ray can enter before its limit: one per boundary crossed on each axis, plus slack for rounding. */
+		std::size_t GetMaxCells(const GridView& grid, const RaySetup& setup)
+		{
+			if (!setup.valid_)
+			{
+				return 0;
+			}
+
+			const float cell_size = static_cast<float>(grid.cell_size_);
+			const Vector2d<float> end = { setup.origin_.x + setup.unit_ray_dir_.x * setup.limit_, setup.origin_.y + setup.unit_ray_dir_.y * setup.limit_ };
+			const int end_x = std::clamp(static_cast<int>(std::floor(end.x / cell_size)), -1, grid.width_);
+			const int end_y = std::clamp(static_cast<int>(std::floor(end.y / cell_size)), -1, grid.height_);
+
+			return static_cast<std::size_t>(std::abs(end_x - setup.map_check_.x) + std::abs(end_y - setup.map_check_.y)) + 2;
+		}
+	} // namespace
+
+	RayCaster::RayCaster(const GridView& grid) : grid_(grid)
+	{
+	}
+
+	RayHit RayCaster::Cast(const Vector2d<float>& origin, const Vector2d<float>& direction, float max_distance) const
+	{
+		return TraverseRaySkipping(grid_, MakeRaySetup(grid_, origin, direction, max_distance));
+	}
+
+	RayHit RayCaster::Cast(const Vector2d<float>& origin, const Vector2d<float>& direction, float max_distance, RayStats& stats) const
+	{
+		return TraverseRaySkipping(grid_, MakeRaySetup(grid_, origin, direction, max_distance), CountStats{ stats });
+	}
+
+	std::size_t RayCaster::CastBatch(Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, Span<RayHit> results, Kernel kernel) const
+	{
+		const PacketKernel traverse = ResolveKernel(kernel);
+		const std::size_t count = std::min({ origins.size(), directions.size(), results.size() });
+
+		constexpr std::size_t chunk_size = 256;
+		RaySetup setups[chunk_size];
+
+		for (std::size_t begin = 0; begin < count; begin += chunk_size)
+		{
+			const std::size_t end = std::min(begin + chunk_size, count);
+
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				setups[i - begin] = MakeRaySetup(grid_, origins[i], directions[i], max_distance);
+			}
+
+			traverse(grid_, setups, end - begin, results.data() + begin);
+		}
+
+		return count;
+	}
+
+	RayBatch RayCaster::CastBatch(Arena& arena, Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, bool record_cells, Kernel kernel) const
+	{
+		const std::size_t count = std::min(origins.size(), directions.size());
+		RayBatch batch = { arena.Allocate<RayHit>(count), {} };
+
+		if (!record_cells)
+		{
+			CastBatch(origins, directions, max_distance, batch.hits_, kernel);
+			return batch;
+		}
+
+		batch.cells_ = arena.Allocate<Span<const Vector2d<int>>>(count);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const RaySetup setup = MakeRaySetup(grid_, origins[i], directions[i], max_distance);
+			const Span<Vector2d<int>> cells = arena.Allocate<Vector2d<int>>(GetMaxCells(grid_, setup));
+			std::size_t entered = 0;
+
+			batch.hits_[i] = TraverseRay(grid_, setup, RecordCells{ grid_, cells, entered });
+			batch.cells_[i] = arena.Shrink(cells, entered);
+		}
+
+		return batch;
+	}
+
+	std::size_t RayCaster::CastBatch(JobPool& pool, Span<const Vector2d<float>> origins, Span<const Vector2d<float>> directions, float max_distance, Span<RayHit> results, Kernel kernel) const
+	{
+		const std::size_t count = std::min({ origins.size(), directions.size(), results.size() });
+
+		constexpr std::size_t chunk_size = 256;
+
+		pool.ParallelFor(count, chunk_size, [&](std::size_t begin, std::size_t end)
+		{
+			CastBatch(origins.subspan(begin, end - begin), directions.subspan(begin, end - begin), max_distance, results.subspan(begin, end - begin), kernel);
+		});
+
+		return count;
+	}
+} // namespace dda
\ No newline at end of file
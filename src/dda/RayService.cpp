@@ -0,0 +1,278 @@
+#include "dda/RayService.hpp"
+#include "dda/Queries.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace dda
+{
+	namespace
+	{
+		/* Appends the header of a response with a body_size-byte body and returns the offset of that body. */
+		std::size_t AppendFrame(std::vector<std::uint8_t>& output, FrameType type, std::uint32_t id, std::uint32_t count, std::size_t body_size)
+		{
+			const FrameHeader header = { static_cast<std::uint32_t>(body_size), static_cast<std::uint16_t>(type), 0, id, count };
+			const std::size_t offset = output.size();
+
+			output.resize(offset + sizeof(FrameHeader) + body_size);
+			std::memcpy(output.data() + offset, &header, sizeof(FrameHeader));
+			return offset + sizeof(FrameHeader);
+		}
+
+		/* Request bodies are aligned for their floats, see Protocol.hpp, and read where they were received. */
+		Span<const Vector2d<float>> GetPoints(Span<const std::uint8_t> body, std::size_t offset, std::size_t count)
+		{
+			return { reinterpret_cast<const Vector2d<float>*>(body.data() + offset), count };
+		}
+
+		/* NaNs and infinities are refused at the door rather than left to every kernel. */
+		bool AreFinite(Span<const Vector2d<float>> points)
+		{
+			return std::all_of(points.begin(), points.end(), [](const Vector2d<float>& point) { return std::isfinite(point.x) && std::isfinite(point.y); });
+		}
+	} // namespace
+
+	void AppendError(std::vector<std::uint8_t>& output, std::uint32_t id, ServiceError error)
+	{
+		const ErrorResult result = { static_cast<std::uint32_t>(error) };
+		const std::size_t offset = AppendFrame(output, FrameType::error, id, 0, sizeof(ErrorResult));
+		std::memcpy(output.data() + offset, &result, sizeof(ErrorResult));
+	}
+
+	RayService::RayService(JobPool& pool) : pool_(pool), version_(0)
+	{
+	}
+
+	void RayService::SetWalls(const GridView& walls)
+	{
+		grid_ = Grid(walls.width_, walls.height_, walls.cell_size_);
+
+		for (int y = 0; y < walls.height_; ++y)
+		{
+			for (int word = 0; word < walls.words_per_row_; ++word)
+			{
+				std::uint64_t bits = walls.words_[static_cast<std::size_t>(y) * walls.words_per_row_ + word];
+
+				while (bits != 0)
+				{
+					grid_.SetWall(word * 64 + __builtin_ctzll(bits), y, true);
+					bits &= bits - 1;
+				}
+			}
+		}
+
+		grid_.ClearDirtyRegion();
+		distance_field_.Build(grid_.GetView());
+		++version_;
+	}
+
+	GridView RayService::GetView() const
+	{
+		return distance_field_.Attach(grid_.GetView());
+	}
+
+	std::uint64_t RayService::GetVersion() const
+	{
+		return version_;
+	}
+
+	bool RayService::Serve(Span<const std::uint8_t> input, std::size_t& consumed, std::vector<std::uint8_t>& output)
+	{
+		consumed = 0;
+
+		while (input.size() - consumed >= sizeof(FrameHeader))
+		{
+			FrameHeader header;
+			std::memcpy(&header, input.data() + consumed, sizeof(FrameHeader));
+
+			if (header.size_ % 4 != 0 || header.size_ > max_frame_body)
+			{
+				AppendError(output, header.id_, ServiceError::malformed_frame);
+				return false;
+			}
+
+			const std::size_t frame_size = sizeof(FrameHeader) + header.size_;
+
+			if (input.size() - consumed < frame_size)
+			{
+				break;
+			}
+
+			const Span<const std::uint8_t> body = input.subspan(consumed + sizeof(FrameHeader), header.size_);
+
+			switch (static_cast<FrameType>(header.type_))
+			{
+			case FrameType::cast:
+				Cast(header, body, output);
+				break;
+
+			case FrameType::line_of_sight:
+				TestLineOfSight(header, body, output);
+				break;
+
+			case FrameType::edit:
+				Edit(header, body, output);
+				break;
+
+			default:
+				AppendError(output, header.id_, ServiceError::unknown_type);
+				break;
+			}
+
+			consumed += frame_size;
+		}
+
+		return true;
+	}
+
+	void RayService::Cast(const FrameHeader& header, Span<const std::uint8_t> body, std::vector<std::uint8_t>& output)
+	{
+		const std::size_t count = header.count_;
+
+		if (body.size() != sizeof(CastRequest) + std::uint64_t{ count } * 2 * sizeof(Vector2d<float>))
+		{
+			AppendError(output, header.id_, ServiceError::bad_size);
+			return;
+		}
+
+		// A hit is larger than its ray, so a request that fits can still
+		// have an answer that does not.
+		if (count * sizeof(HitResult) > max_frame_body)
+		{
+			AppendError(output, header.id_, ServiceError::response_too_large);
+			return;
+		}
+
+		CastRequest request;
+		std::memcpy(&request, body.data(), sizeof(CastRequest));
+
+		// Kernel::neon is the last kernel.
+		if (request.kernel_ > static_cast<std::uint8_t>(Kernel::neon))
+		{
+			AppendError(output, header.id_, ServiceError::bad_kernel);
+			return;
+		}
+
+		const Span<const Vector2d<float>> origins = GetPoints(body, sizeof(CastRequest), count);
+		const Span<const Vector2d<float>> directions = GetPoints(body, sizeof(CastRequest) + count * sizeof(Vector2d<float>), count);
+
+		if (!std::isfinite(request.max_distance_) || !AreFinite(origins) || !AreFinite(directions))
+		{
+			AppendError(output, header.id_, ServiceError::bad_value);
+			return;
+		}
+
+		// Any finite max_distance is safe: RaySetup clips every ray to the
+		// grid, so no ray steps past the grid's far edge.
+		hits_.resize(count);
+		RayCaster(GetView()).CastBatch(pool_, origins, directions, request.max_distance_, hits_, static_cast<Kernel>(request.kernel_));
+
+		const std::size_t offset = AppendFrame(output, FrameType::cast_result, header.id_, header.count_, count * sizeof(HitResult));
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const RayHit& hit = hits_[i];
+			const HitResult result = { hit.cell_.x, hit.cell_.y, hit.point_.x, hit.point_.y, hit.distance_, static_cast<std::uint8_t>(hit.hit_), static_cast<std::uint8_t>(hit.face_), {} };
+			std::memcpy(output.data() + offset + i * sizeof(HitResult), &result, sizeof(HitResult));
+		}
+	}
+
+	void RayService::TestLineOfSight(const FrameHeader& header, Span<const std::uint8_t> body, std::vector<std::uint8_t>& output)
+	{
+		const std::size_t count = header.count_;
+
+		if (body.size() != sizeof(LineOfSightRequest) + std::uint64_t{ count } * sizeof(Vector2d<float>))
+		{
+			AppendError(output, header.id_, ServiceError::bad_size);
+			return;
+		}
+
+		const std::size_t word_count = (count + 31) / 32;
+
+		if (word_count * sizeof(std::uint32_t) > max_frame_body)
+		{
+			AppendError(output, header.id_, ServiceError::response_too_large);
+			return;
+		}
+
+		LineOfSightRequest request;
+		std::memcpy(&request, body.data(), sizeof(LineOfSightRequest));
+
+		const Vector2d<float> origin = { request.origin_x_, request.origin_y_ };
+		const Span<const Vector2d<float>> targets = GetPoints(body, sizeof(LineOfSightRequest), count);
+
+		if (!std::isfinite(origin.x) || !std::isfinite(origin.y) || !AreFinite(targets))
+		{
+			AppendError(output, header.id_, ServiceError::bad_value);
+			return;
+		}
+
+		visible_.resize(count);
+
+		const GridView view = GetView();
+		const Span<std::uint8_t> visible = visible_;
+
+		// Each chunk sorts its own targets by angle; chunks only need to be
+		// large enough for neighbouring rays to share cells.
+		pool_.ParallelFor(count, 1024, [&](std::size_t begin, std::size_t end)
+		{
+			HasLineOfSight(view, origin, targets.subspan(begin, end - begin), visible.subspan(begin, end - begin));
+		});
+
+		const std::size_t offset = AppendFrame(output, FrameType::visible_result, header.id_, header.count_, word_count * sizeof(std::uint32_t));
+
+		for (std::size_t word = 0; word < word_count; ++word)
+		{
+			std::uint32_t bits = 0;
+
+			for (std::size_t bit = 0; bit < 32 && word * 32 + bit < count; ++bit)
+			{
+				bits |= static_cast<std::uint32_t>(visible_[word * 32 + bit] != 0) << bit;
+			}
+
+			std::memcpy(output.data() + offset + word * sizeof(std::uint32_t), &bits, sizeof(std::uint32_t));
+		}
+	}
+
+	void RayService::Edit(const FrameHeader& header, Span<const std::uint8_t> body, std::vector<std::uint8_t>& output)
+	{
+		const std::size_t count = header.count_;
+
+		if (body.size() != std::uint64_t{ count } * sizeof(EditDelta))
+		{
+			AppendError(output, header.id_, ServiceError::bad_size);
+			return;
+		}
+
+		std::uint32_t changed = 0;
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			EditDelta delta;
+			std::memcpy(&delta, body.data() + i * sizeof(EditDelta), sizeof(EditDelta));
+
+			const bool wall = delta.wall_ != 0;
+
+			if (grid_.GetView().Contains(delta.x_, delta.y_) && grid_.IsWall(delta.x_, delta.y_) != wall)
+			{
+				grid_.SetWall(delta.x_, delta.y_, wall);
+				++changed;
+			}
+		}
+
+		// The pyramid followed every SetWall; the field catches up with the
+		// tiles they touched once per frame.
+		if (changed != 0)
+		{
+			distance_field_.Update(grid_.GetView(), grid_.GetDirtyRegion());
+			grid_.ClearDirtyRegion();
+		}
+
+		++version_;
+
+		const EditResult result = { version_, changed, 0 };
+		const std::size_t offset = AppendFrame(output, FrameType::edit_result, header.id_, header.count_, sizeof(EditResult));
+		std::memcpy(output.data() + offset, &result, sizeof(EditResult));
+	}
+} // namespace dda
\ No newline at end of file
@@ -0,0 +1,482 @@
+#ifndef DDA_TRAVERSAL_HPP
+#define DDA_TRAVERSAL_HPP
+
+#include "dda/Grid.hpp"
+#include "dda/RayCaster.hpp"
+#include "Vector2d.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace dda
+{
+	/*
+	 * Everything the inner DDA loop needs, computed once per ray. Keeping
+	 * the setup separate from the stepping lets the batch and packet paths
+	 * prepare many rays before traversing any of them.
+	 *
+	 * Rays are clipped against the grid up front: a ray starting outside is
+	 * seeded one cell before its entry point, and limit_ is the smaller of
+	 * max_distance and the distance at which the ray leaves the grid, so it
+	 * is finite. A ray that never touches the grid is not valid_, and nor is
+	 * one with a non-finite origin or direction, or one from so far outside
+	 * that its steps would be lost to rounding at those distances: every
+	 * valid_ ray's loop reaches limit_.
+	 */
+	struct RaySetup
+	{
+		Vector2d<float> origin_;
+		Vector2d<float> unit_ray_dir_;
+		Vector2d<float> ray_step_size_;
+		Vector2d<float> ray_length_;
+		Vector2d<int> map_check_;
+		Vector2d<int> step_;
+		float limit_;
+		bool valid_;
+	};
+
+	/* Distance along the ray to the next boundary it crosses on one axis after leaving cell. */
+	inline float NextBoundaryDistance(float origin, float unit_ray_dir, int step, int cell, float cell_size)
+	{
+		if (step == 0)
+		{
+			return std::numeric_limits<float>::infinity();
+		}
+
+		return (static_cast<float>(step > 0 ? cell + 1 : cell) * cell_size - origin) / unit_ray_dir;
+	}
+
+	/* Parametric interval [near, far] in which the ray lies within [0, extent) on one axis. */
+	inline bool ClipAxis(float origin, float unit_ray_dir, float extent, float& near, float& far)
+	{
+		if (unit_ray_dir == 0.0f)
+		{
+			return origin >= 0.0f && origin < extent;
+		}
+
+		const float t0 = (0.0f - origin) / unit_ray_dir;
+		const float t1 = (extent - origin) / unit_ray_dir;
+		near = std::max(near, std::min(t0, t1));
+		far = std::min(far, std::max(t0, t1));
+		return true;
+	}
+
+	/* Whether the DDA loop for setup ends: it steps on some axis, and each of its steps still advances distances up to limit_, which also fails if limit_ is not finite. */
+	inline bool ReachesLimit(const RaySetup& setup)
+	{
+		return (setup.step_.x != 0 || setup.step_.y != 0) && (setup.step_.x == 0 || setup.limit_ + setup.ray_step_size_.x > setup.limit_) && (setup.step_.y == 0 || setup.limit_ + setup.ray_step_size_.y > setup.limit_);
+	}
+
+	inline RaySetup MakeRaySetup(const GridView& grid, const Vector2d<float>& origin, const Vector2d<float>& direction, float max_distance)
+	{
+		constexpr float infinity = std::numeric_limits<float>::infinity();
+
+		RaySetup setup = { origin, { 0.0f, 0.0f }, { infinity, infinity }, { infinity, infinity }, { 0, 0 }, { 0, 0 }, 0.0f, false };
+
+		if (!std::isfinite(origin.x) || !std::isfinite(origin.y) || direction.GetLength() == 0.0f)
+		{
+			return setup;
+		}
+
+		setup.unit_ray_dir_ = direction;
+		setup.unit_ray_dir_.Normalize();
+
+		if (!std::isfinite(setup.unit_ray_dir_.x) || !std::isfinite(setup.unit_ray_dir_.y))
+		{
+			setup.unit_ray_dir_ = { 0.0f, 0.0f };
+			return setup;
+		}
+
+		const Vector2d<float>& unit_ray_dir = setup.unit_ray_dir_;
+		const float cell_size = static_cast<float>(grid.cell_size_);
+
+		float enter_x = 0.0f;
+		float enter_y = 0.0f;
+		float exit = max_distance;
+
+		if (!ClipAxis(origin.x, unit_ray_dir.x, static_cast<float>(grid.width_) * cell_size, enter_x, exit) || !ClipAxis(origin.y, unit_ray_dir.y, static_cast<float>(grid.height_) * cell_size, enter_y, exit))
+		{
+			return setup;
+		}
+
+		const float enter = std::max(enter_x, enter_y);
+
+		// Also rejects a NaN max_distance.
+		if (!(enter <= exit))
+		{
+			return setup;
+		}
+
+		setup.limit_ = exit;
+		setup.step_ = { unit_ray_dir.x < 0.0f ? -1 : (unit_ray_dir.x > 0.0f ? 1 : 0), unit_ray_dir.y < 0.0f ? -1 : (unit_ray_dir.y > 0.0f ? 1 : 0) };
+		setup.ray_step_size_ = { setup.step_.x != 0 ? cell_size / std::abs(unit_ray_dir.x) : infinity, setup.step_.y != 0 ? cell_size / std::abs(unit_ray_dir.y) : infinity };
+		setup.valid_ = ReachesLimit(setup);
+
+		if (!setup.valid_)
+		{
+			return setup;
+		}
+
+		if (enter == 0.0f)
+		{
+			setup.map_check_ = { static_cast<int>(std::floor(origin.x / cell_size)), static_cast<int>(std::floor(origin.y / cell_size)) };
+			setup.ray_length_.x = NextBoundaryDistance(origin.x, unit_ray_dir.x, setup.step_.x, setup.map_check_.x, cell_size);
+			setup.ray_length_.y = NextBoundaryDistance(origin.y, unit_ray_dir.y, setup.step_.y, setup.map_check_.y, cell_size);
+			return setup;
+		}
+
+		const Vector2d<float> entry = { origin.x + unit_ray_dir.x * enter, origin.y + unit_ray_dir.y * enter };
+
+		if (enter_x >= enter_y)
+		{
+			setup.map_check_.x = (setup.step_.x > 0 ? 0 : grid.width_ - 1) - setup.step_.x;
+			setup.map_check_.y = std::clamp(static_cast<int>(std::floor(entry.y / cell_size)), 0, grid.height_ - 1);
+			setup.ray_length_.x = enter;
+			setup.ray_length_.y = NextBoundaryDistance(origin.y, unit_ray_dir.y, setup.step_.y, setup.map_check_.y, cell_size);
+		}
+		else
+		{
+			setup.map_check_.x = std::clamp(static_cast<int>(std::floor(entry.x / cell_size)), 0, grid.width_ - 1);
+			setup.map_check_.y = (setup.step_.y > 0 ? 0 : grid.height_ - 1) - setup.step_.y;
+			setup.ray_length_.x = NextBoundaryDistance(origin.x, unit_ray_dir.x, setup.step_.x, setup.map_check_.x, cell_size);
+			setup.ray_length_.y = enter;
+		}
+
+		return setup;
+	}
+
+	/*
+	 * The part of MakeRaySetup that depends only on the origin, shared by
+	 * fans of rays from one point: the containing cell and the distances
+	 * from the origin to that cell's edges on each axis.
+	 */
+	struct OriginSetup
+	{
+		Vector2d<float> origin_;
+		Vector2d<int> cell_;
+		Vector2d<float> to_lower_;
+		Vector2d<float> to_upper_;
+		bool inside_;
+	};
+
+	inline OriginSetup MakeOriginSetup(const GridView& grid, const Vector2d<float>& origin)
+	{
+		const float cell_size = static_cast<float>(grid.cell_size_);
+
+		// The general path rejects what cannot be turned into a cell.
+		if (!std::isfinite(origin.x) || !std::isfinite(origin.y))
+		{
+			return { origin, { 0, 0 }, { 0.0f, 0.0f }, { 0.0f, 0.0f }, false };
+		}
+
+		const Vector2d<int> cell = { static_cast<int>(std::floor(origin.x / cell_size)), static_cast<int>(std::floor(origin.y / cell_size)) };
+
+		return { origin, cell, { static_cast<float>(cell.x) * cell_size - origin.x, static_cast<float>(cell.y) * cell_size - origin.y }, { static_cast<float>(cell.x + 1) * cell_size - origin.x, static_cast<float>(cell.y + 1) * cell_size - origin.y }, grid.Contains(cell.x, cell.y) };
+	}
+
+	/*
+	 * MakeRaySetup for a unit-length direction from a prepared origin. Skips
+	 * the normalization, floor and per-axis boundary offsets, and gives the
+	 * same setup as MakeRaySetup for the normalized direction. Origins
+	 * outside of the grid take the general path.
+	 */
+	inline RaySetup MakeRaySetup(const GridView& grid, const OriginSetup& origin_setup, const Vector2d<float>& unit_ray_dir, float max_distance)
+	{
+		if (!origin_setup.inside_)
+		{
+			return MakeRaySetup(grid, origin_setup.origin_, unit_ray_dir, max_distance);
+		}
+
+		constexpr float infinity = std::numeric_limits<float>::infinity();
+
+		const Vector2d<float>& origin = origin_setup.origin_;
+		const float cell_size = static_cast<float>(grid.cell_size_);
+
+		float enter = 0.0f;
+		float exit = max_distance;
+		ClipAxis(origin.x, unit_ray_dir.x, static_cast<float>(grid.width_) * cell_size, enter, exit);
+		ClipAxis(origin.y, unit_ray_dir.y, static_cast<float>(grid.height_) * cell_size, enter, exit);
+
+		RaySetup setup;
+		setup.origin_ = origin;
+		setup.unit_ray_dir_ = unit_ray_dir;
+		setup.map_check_ = origin_setup.cell_;
+		setup.limit_ = exit;
+		setup.step_ = { unit_ray_dir.x < 0.0f ? -1 : (unit_ray_dir.x > 0.0f ? 1 : 0), unit_ray_dir.y < 0.0f ? -1 : (unit_ray_dir.y > 0.0f ? 1 : 0) };
+		setup.ray_step_size_ = { setup.step_.x != 0 ? cell_size / std::abs(unit_ray_dir.x) : infinity, setup.step_.y != 0 ? cell_size / std::abs(unit_ray_dir.y) : infinity };
+		setup.valid_ = enter <= exit && ReachesLimit(setup);
+		setup.ray_length_.x = setup.step_.x != 0 ? (setup.step_.x > 0 ? origin_setup.to_upper_.x : origin_setup.to_lower_.x) / unit_ray_dir.x : infinity;
+		setup.ray_length_.y = setup.step_.y != 0 ? (setup.step_.y > 0 ? origin_setup.to_upper_.y : origin_setup.to_lower_.y) / unit_ray_dir.y : infinity;
+		return setup;
+	}
+
+	inline RayHit MakeHit(const RaySetup& setup, const Vector2d<int>& cell, float distance, HitFace face)
+	{
+		return { true, cell, { setup.origin_.x + setup.unit_ray_dir_.x * distance, setup.origin_.y + setup.unit_ray_dir_.y * distance }, distance, face };
+	}
+
+	inline RayHit MakeMiss()
+	{
+		return { false, { -1, -1 }, { -1.0f, -1.0f }, 0.0f, HitFace::none };
+	}
+
+	/* Cell visitor for TraverseRay that compiles away; visitors see every cell the ray enters, in order. */
+	struct IgnoreCells
+	{
+		void operator()(const Vector2d<int>&)
+		{
+		}
+	};
+
+	/* Cells is GridView or any other source of cells with IsWall; see TraverseRaySkipping. */
+	template <typename Cells, typename Visit = IgnoreCells>
+	RayHit TraverseRay(Cells& grid, const RaySetup& setup, Visit visit = Visit())
+	{
+		if (!setup.valid_)
+		{
+			return MakeMiss();
+		}
+
+		Vector2d<float> ray_length = setup.ray_length_;
+		Vector2d<int> map_check = setup.map_check_;
+		float distance = 0.0f;
+
+		while (distance <= setup.limit_)
+		{
+			HitFace face;
+
+			if (ray_length.x < ray_length.y)
+			{
+				map_check.x += setup.step_.x;
+				distance = ray_length.x;
+				ray_length.x += setup.ray_step_size_.x;
+				face = setup.step_.x > 0 ? HitFace::west : HitFace::east;
+			}
+			else
+			{
+				map_check.y += setup.step_.y;
+				distance = ray_length.y;
+				ray_length.y += setup.ray_step_size_.y;
+				face = setup.step_.y > 0 ? HitFace::north : HitFace::south;
+			}
+
+			if (distance > setup.limit_)
+			{
+				break;
+			}
+
+			visit(map_check);
+
+			if (grid.IsWall(map_check.x, map_check.y))
+			{
+				return MakeHit(setup, map_check, distance, face);
+			}
+		}
+
+		return MakeMiss();
+	}
+
+	/* Stats policies for TraverseRaySkipping; IgnoreStats compiles away entirely. */
+	struct IgnoreStats
+	{
+		void CountStep()
+		{
+		}
+
+		void CountSkip()
+		{
+		}
+	};
+
+	struct CountStats
+	{
+		RayStats& stats_;
+
+		void CountStep()
+		{
+			++stats_.steps_;
+		}
+
+		void CountSkip()
+		{
+			++stats_.skips_;
+		}
+	};
+
+	/*
+	 * Moves a ray from inside the wall-free box [box_min, box_max] of cells
+	 * to the first cell past it, reseeding the DDA state there.
+	 */
+	inline void ExitEmptyBox(const RaySetup& setup, float cell_size, const Vector2d<int>& box_min, const Vector2d<int>& box_max, Vector2d<int>& map_check, Vector2d<float>& ray_length, float& distance, HitFace& face)
+	{
+		const Vector2d<float>& origin = setup.origin_;
+		const Vector2d<float>& unit_ray_dir = setup.unit_ray_dir_;
+		const Vector2d<int>& step = setup.step_;
+
+		const float exit_x = NextBoundaryDistance(origin.x, unit_ray_dir.x, step.x, step.x > 0 ? box_max.x : box_min.x, cell_size);
+		const float exit_y = NextBoundaryDistance(origin.y, unit_ray_dir.y, step.y, step.y > 0 ? box_max.y : box_min.y, cell_size);
+
+		if (exit_x < exit_y)
+		{
+			distance = exit_x;
+			map_check.x = step.x > 0 ? box_max.x + 1 : box_min.x - 1;
+			map_check.y = std::clamp(static_cast<int>(std::floor((origin.y + unit_ray_dir.y * distance) / cell_size)), box_min.y, box_max.y);
+			face = step.x > 0 ? HitFace::west : HitFace::east;
+		}
+		else
+		{
+			distance = exit_y;
+			map_check.x = std::clamp(static_cast<int>(std::floor((origin.x + unit_ray_dir.x * distance) / cell_size)), box_min.x, box_max.x);
+			map_check.y = step.y > 0 ? box_max.y + 1 : box_min.y - 1;
+			face = step.y > 0 ? HitFace::north : HitFace::south;
+		}
+
+		ray_length.x = NextBoundaryDistance(origin.x, unit_ray_dir.x, step.x, map_check.x, cell_size);
+		ray_length.y = NextBoundaryDistance(origin.y, unit_ray_dir.y, step.y, map_check.y, cell_size);
+	}
+
+	/*
+	 * TraverseRay with empty-space skipping. While the current cell lies in
+	 * an empty pyramid block, the ray jumps straight to the cell where it
+	 * leaves that block and the DDA state is reseeded there. Inside occupied
+	 * blocks it steps cell by cell as usual. Reseeding recomputes the ray
+	 * lengths instead of accumulating them, so distances can differ from
+	 * TraverseRay in the last bits.
+	 *
+	 * Cells is GridView or any other source of cells with cell_size_,
+	 * GetEmptyBlockShift and IsWall, such as the chunk cursor of
+	 * ChunkedWorld.
+	 */
+	template <typename Cells, typename Stats = IgnoreStats>
+	RayHit TraverseRaySkipping(Cells& grid, const RaySetup& setup, Stats stats = Stats())
+	{
+		if (!setup.valid_)
+		{
+			return MakeMiss();
+		}
+
+		const Vector2d<int>& step = setup.step_;
+		const float cell_size = static_cast<float>(grid.cell_size_);
+
+		Vector2d<float> ray_length = setup.ray_length_;
+		Vector2d<int> map_check = setup.map_check_;
+		float distance = 0.0f;
+
+		while (true)
+		{
+			HitFace face;
+			const int block_shift = grid.GetEmptyBlockShift(map_check.x, map_check.y);
+
+			if (block_shift != 0)
+			{
+				const Vector2d<int> block_min = { (map_check.x >> block_shift) << block_shift, (map_check.y >> block_shift) << block_shift };
+				const Vector2d<int> block_max = { block_min.x + (1 << block_shift) - 1, block_min.y + (1 << block_shift) - 1 };
+
+				ExitEmptyBox(setup, cell_size, block_min, block_max, map_check, ray_length, distance, face);
+				stats.CountSkip();
+			}
+			else if (ray_length.x < ray_length.y)
+			{
+				map_check.x += step.x;
+				distance = ray_length.x;
+				ray_length.x += setup.ray_step_size_.x;
+				face = step.x > 0 ? HitFace::west : HitFace::east;
+			}
+			else
+			{
+				map_check.y += step.y;
+				distance = ray_length.y;
+				ray_length.y += setup.ray_step_size_.y;
+				face = step.y > 0 ? HitFace::north : HitFace::south;
+			}
+
+			if (block_shift == 0)
+			{
+				stats.CountStep();
+			}
+
+			if (distance > setup.limit_)
+			{
+				break;
+			}
+
+			if (grid.IsWall(map_check.x, map_check.y))
+			{
+				return MakeHit(setup, map_check, distance, face);
+			}
+		}
+
+		return MakeMiss();
+	}
+
+	/*
+	 * TraverseRaySkipping with the jumps sized by a DistanceField: a cell of
+	 * clearance d is the centre of an empty square reaching d - 1 cells to
+	 * each side, which the ray leaves in one jump. Where the square reaches
+	 * less than two cells a jump does not repay the reseeding, so next to
+	 * walls it steps as usual; on cluttered maps that is most of the way,
+	 * and the plain DDA is faster. Distances can differ from TraverseRay
+	 * in the last bits, as for TraverseRaySkipping.
+	 *
+	 * Cells is GridView or any other source of cells with cell_size_,
+	 * GetClearance and IsWall.
+	 */
+	template <typename Cells, typename Stats = IgnoreStats>
+	RayHit TraverseRayJumping(Cells& grid, const RaySetup& setup, Stats stats = Stats())
+	{
+		if (!setup.valid_)
+		{
+			return MakeMiss();
+		}
+
+		const Vector2d<int>& step = setup.step_;
+		const float cell_size = static_cast<float>(grid.cell_size_);
+
+		Vector2d<float> ray_length = setup.ray_length_;
+		Vector2d<int> map_check = setup.map_check_;
+		float distance = 0.0f;
+
+		while (true)
+		{
+			HitFace face;
+			const int reach = grid.GetClearance(map_check.x, map_check.y) - 1;
+
+			if (reach > 1)
+			{
+				ExitEmptyBox(setup, cell_size, { map_check.x - reach, map_check.y - reach }, { map_check.x + reach, map_check.y + reach }, map_check, ray_length, distance, face);
+				stats.CountSkip();
+			}
+			else if (ray_length.x < ray_length.y)
+			{
+				map_check.x += step.x;
+				distance = ray_length.x;
+				ray_length.x += setup.ray_step_size_.x;
+				face = step.x > 0 ? HitFace::west : HitFace::east;
+				stats.CountStep();
+			}
+			else
+			{
+				map_check.y += step.y;
+				distance = ray_length.y;
+				ray_length.y += setup.ray_step_size_.y;
+				face = step.y > 0 ? HitFace::north : HitFace::south;
+				stats.CountStep();
+			}
+
+			if (distance > setup.limit_)
+			{
+				break;
+			}
+
+			if (grid.IsWall(map_check.x, map_check.y))
+			{
+				return MakeHit(setup, map_check, distance, face);
+			}
+		}
+
+		return MakeMiss();
+	}
+} // namespace dda
+
+#endif
\ No newline at end of file
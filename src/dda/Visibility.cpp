@@ -0,0 +1,488 @@
+#include "dda/Visibility.hpp"
+#include "Packet.hpp"
+#include "Traversal.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dda
+{
+	namespace
+	{
+		constexpr float two_pi = 6.28318530717958647692f;
+
+		/* Half the angle between the two rays cast past a corner. */
+		constexpr float corner_epsilon = 1e-4f;
+
+		/* Fills points[i] with where the ray at angles[i] stops; points must be as long as angles. */
+		void CastAngles(const GridView& grid, const OriginSetup& origin_setup, Span<const float> angles, float max_distance, Kernel kernel, Span<Vector2d<float>> points)
+		{
+			const PacketKernel traverse = ResolveKernel(kernel);
+
+			constexpr std::size_t chunk_size = 256;
+			RaySetup setups[chunk_size];
+			RayHit results[chunk_size];
+
+			for (std::size_t begin = 0; begin < angles.size(); begin += chunk_size)
+			{
+				const std::size_t end = std::min(begin + chunk_size, angles.size());
+
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					setups[i - begin] = MakeRaySetup(grid, origin_setup, { std::cos(angles[i]), std::sin(angles[i]) }, max_distance);
+				}
+
+				traverse(grid, setups, end - begin, results);
+
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					const RaySetup& setup = setups[i - begin];
+					const RayHit& hit = results[i - begin];
+
+					if (hit.hit_)
+					{
+						points[i] = hit.point_;
+					}
+					else if (setup.valid_)
+					{
+						points[i] = { setup.origin_.x + setup.unit_ray_dir_.x * setup.limit_, setup.origin_.y + setup.unit_ray_dir_.y * setup.limit_ };
+					}
+					else
+					{
+						points[i] = setup.origin_;
+					}
+				}
+			}
+		}
+
+		void MakeFanAngles(float angle, float spread, bool closed, Span<float> angles)
+		{
+			const int ray_count = static_cast<int>(angles.size());
+			const float start = closed ? angle - two_pi / 2.0f : angle - spread / 2.0f;
+			const float step = closed ? two_pi / static_cast<float>(ray_count) : (ray_count > 1 ? spread / static_cast<float>(ray_count - 1) : 0.0f);
+
+			for (int i = 0; i < ray_count; ++i)
+			{
+				angles[i] = start + step * static_cast<float>(i);
+			}
+		}
+
+		/*
+		 * A grid vertex is a corner of the outline if its four cells, counting
+		 * outside ones as walls, do not form a straight edge. Rays leave the
+		 * cell they start in, so origin_cell never counts as a wall.
+		 */
+		bool IsCorner(const GridView& grid, int x, int y, const Vector2d<int>& origin_cell)
+		{
+			const auto solid = [&](int cell_x, int cell_y)
+			{
+				return !grid.Contains(cell_x, cell_y) || (grid.IsWall(cell_x, cell_y) && (cell_x != origin_cell.x || cell_y != origin_cell.y));
+			};
+
+			const bool top_left = solid(x - 1, y - 1);
+			const bool top_right = solid(x, y - 1);
+			const bool bottom_left = solid(x - 1, y);
+			const bool bottom_right = solid(x, y);
+			const int count = top_left + top_right + bottom_left + bottom_right;
+
+			return count == 1 || count == 3 || (count == 2 && top_left == bottom_right);
+		}
+
+		/* Calls visit(x, y) for every wall in cells [min_x, max_x) x [min_y, max_y), skipping the pyramid's empty blocks. */
+		template <typename Visit>
+		void ForEachWall(const GridView& grid, int min_x, int min_y, int max_x, int max_y, Visit visit)
+		{
+			if (min_x >= max_x || min_y >= max_y)
+			{
+				return;
+			}
+
+			const int coarse_blocks_per_row = BlocksPerSide(grid.width_, coarse_block_shift);
+			const int fine_blocks_per_row = BlocksPerSide(grid.width_, fine_block_shift);
+
+			for (int coarse_y = min_y >> coarse_block_shift; coarse_y <= (max_y - 1) >> coarse_block_shift; ++coarse_y)
+			{
+				for (int coarse_x = min_x >> coarse_block_shift; coarse_x <= (max_x - 1) >> coarse_block_shift; ++coarse_x)
+				{
+					if (grid.coarse_blocks_ != nullptr && grid.coarse_blocks_[static_cast<std::size_t>(coarse_y) * coarse_blocks_per_row + coarse_x] == 0)
+					{
+						continue;
+					}
+
+					const int block_min_x = std::max(min_x, coarse_x << coarse_block_shift);
+					const int block_min_y = std::max(min_y, coarse_y << coarse_block_shift);
+					const int block_max_x = std::min(max_x, (coarse_x + 1) << coarse_block_shift);
+					const int block_max_y = std::min(max_y, (coarse_y + 1) << coarse_block_shift);
+
+					for (int fine_y = block_min_y >> fine_block_shift; fine_y <= (block_max_y - 1) >> fine_block_shift; ++fine_y)
+					{
+						for (int fine_x = block_min_x >> fine_block_shift; fine_x <= (block_max_x - 1) >> fine_block_shift; ++fine_x)
+						{
+							if (grid.fine_blocks_ != nullptr && grid.fine_blocks_[static_cast<std::size_t>(fine_y) * fine_blocks_per_row + fine_x] == 0)
+							{
+								continue;
+							}
+
+							// A fine block never straddles two words of a row.
+							const int cells_min_x = std::max(block_min_x, fine_x << fine_block_shift);
+							const int cells_max_x = std::min(block_max_x, (fine_x + 1) << fine_block_shift);
+							const std::uint64_t mask = ((std::uint64_t{ 1 } << (cells_max_x - cells_min_x)) - 1) << (cells_min_x & 63);
+
+							for (int y = std::max(block_min_y, fine_y << fine_block_shift); y < std::min(block_max_y, (fine_y + 1) << fine_block_shift); ++y)
+							{
+								std::uint64_t walls = grid.words_[static_cast<std::size_t>(y) * grid.words_per_row_ + (cells_min_x >> 6)] & mask;
+
+								while (walls != 0)
+								{
+									visit((cells_min_x & ~63) + __builtin_ctzll(walls), y);
+									walls &= walls - 1;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		/* Slopes [low_, high_] of rays still travelling through a quadrant, see ForEachVisibleVertex. */
+		struct LitInterval
+		{
+			double low_;
+			double high_;
+		};
+
+		/*
+		 * Calls visit(x, y) for the grid vertices within reach that can be
+		 * seen from origin, which must lie in the grid, and that touch a
+		 * wall or are a corner of the grid. Like the kernels, rays leave the
+		 * origin's own cell even if it is a wall. Each quadrant around origin
+		 * is swept a strip of cells at a time, moving away from it, keeping
+		 * the intervals of slopes whose rays no wall has stopped yet; a
+		 * vertex on the far side of a strip is visible if its slope lies in
+		 * one. The pyramid's empty blocks are skipped, so the work grows with
+		 * the visible walls rather than the map. A vertex on a quadrant's
+		 * edge may be visited twice.
+		 */
+		template <typename Visit>
+		void ForEachVisibleVertex(const GridView& grid, const Vector2d<float>& origin, float reach, Visit visit)
+		{
+			constexpr double infinity = std::numeric_limits<double>::infinity();
+			const double cell_size = grid.cell_size_;
+			std::vector<LitInterval> lit;
+			std::vector<LitInterval> next_lit;
+
+			for (int quadrant = 0; quadrant < 4; ++quadrant)
+			{
+				// Columns right and left of the origin, then rows below and
+				// above it. Strips are at distance u along the primary axis,
+				// and v runs along them, so a slope is v / u.
+				const bool columns = quadrant < 2;
+				const int direction = quadrant % 2 == 0 ? 1 : -1;
+				const double primary = columns ? origin.x : origin.y;
+				const double secondary = columns ? origin.y : origin.x;
+				const int primary_cells = columns ? grid.width_ : grid.height_;
+				const int secondary_cells = columns ? grid.height_ : grid.width_;
+				const int origin_primary = static_cast<int>(std::floor(primary / cell_size));
+				const int origin_secondary = static_cast<int>(std::floor(secondary / cell_size));
+
+				// Calls found(s) for every wall in strip p from cell s = first to last, in order.
+				const auto for_each_wall = [&](int p, int first, int last, auto found)
+				{
+					last = std::min(last, secondary_cells - 1);
+
+					for (int s = std::max(first, 0); s <= last;)
+					{
+						const int shift = columns ? grid.GetEmptyBlockShift(p, s) : grid.GetEmptyBlockShift(s, p);
+
+						if (shift > 0)
+						{
+							s = ((s >> shift) + 1) << shift;
+							continue;
+						}
+
+						if (columns ? grid.IsWall(p, s) : grid.IsWall(s, p))
+						{
+							found(s);
+						}
+
+						++s;
+					}
+				};
+
+				lit.assign(1, { -1.0, 1.0 });
+
+				int cell = static_cast<int>(direction > 0 ? std::floor(primary / cell_size) : std::ceil(primary / cell_size) - 1.0);
+				double near_distance = 0.0;
+
+				while (!lit.empty() && cell >= 0 && cell < primary_cells && near_distance <= reach)
+				{
+					// If the lit rows, and one either side, are empty in the
+					// coarse blocks up to the last strip of this column of
+					// them, no strip before that cuts the intervals or has a
+					// corner on its far side, so the sweep jumps ahead.
+					const int last_cell = direction > 0 ? std::min(((cell >> coarse_block_shift) + 1) << coarse_block_shift, primary_cells) - 1 : (cell >> coarse_block_shift) << coarse_block_shift;
+
+					if (grid.coarse_blocks_ != nullptr && last_cell != cell)
+					{
+						const double last_far = direction * ((direction > 0 ? last_cell + 1 : last_cell) * cell_size - primary);
+						double v_min = infinity;
+						double v_max = -infinity;
+
+						for (const LitInterval& interval : lit)
+						{
+							v_min = std::min(v_min, std::min(interval.low_ * near_distance, interval.low_ * last_far));
+							v_max = std::max(v_max, std::max(interval.high_ * near_distance, interval.high_ * last_far));
+						}
+
+						const int first_row = std::max(static_cast<int>(std::floor((secondary + v_min) / cell_size)) - 1, 0);
+						const int last_row = std::min(static_cast<int>(std::floor((secondary + v_max) / cell_size)) + 1, secondary_cells - 1);
+						bool empty = true;
+
+						for (int block = first_row >> coarse_block_shift; empty && block <= last_row >> coarse_block_shift; ++block)
+						{
+							const int block_x = columns ? cell >> coarse_block_shift : block;
+							const int block_y = columns ? block : cell >> coarse_block_shift;
+							empty = grid.coarse_blocks_[static_cast<std::size_t>(block_y) * BlocksPerSide(grid.width_, coarse_block_shift) + block_x] == 0;
+						}
+
+						if (empty)
+						{
+							cell = last_cell;
+							near_distance = direction * ((direction > 0 ? last_cell : last_cell + 1) * cell_size - primary);
+						}
+					}
+
+					const int line = direction > 0 ? cell + 1 : cell;
+					const double far_distance = direction * (line * cell_size - primary);
+
+					// Walls in the strip cut the rays crossing them out of
+					// the intervals. Being in row order, their slopes rise.
+					next_lit.clear();
+
+					for (const LitInterval& interval : lit)
+					{
+						double low = interval.low_;
+						const double v_min = std::min(interval.low_ * near_distance, interval.low_ * far_distance);
+						const double v_max = std::max(interval.high_ * near_distance, interval.high_ * far_distance);
+
+						for_each_wall(cell, static_cast<int>(std::floor((secondary + v_min) / cell_size)), static_cast<int>(std::floor((secondary + v_max) / cell_size)), [&](int s)
+						{
+							if (cell == origin_primary && s == origin_secondary)
+							{
+								return;
+							}
+
+							const double top = s * cell_size - secondary;
+							const double bottom = (s + 1) * cell_size - secondary;
+							const double blocked_low = top >= 0.0 ? top / far_distance : (near_distance > 0.0 ? top / near_distance : -infinity);
+							const double blocked_high = bottom <= 0.0 ? bottom / far_distance : (near_distance > 0.0 ? bottom / near_distance : infinity);
+							const double end = std::min(blocked_low, interval.high_);
+
+							if (end > low)
+							{
+								next_lit.push_back({ low, end });
+							}
+
+							low = std::max(low, blocked_high);
+						});
+
+						if (low < interval.high_)
+						{
+							next_lit.push_back({ low, interval.high_ });
+						}
+					}
+
+					lit.swap(next_lit);
+
+					// Vertices on the far_distance side of the strip touching a wall
+					// touch one in this strip or the next.
+					for (const LitInterval& interval : lit)
+					{
+						const int first = static_cast<int>(std::floor((secondary + interval.low_ * far_distance) / cell_size));
+						const int last = static_cast<int>(std::ceil((secondary + interval.high_ * far_distance) / cell_size));
+
+						const auto candidate = [&](int s)
+						{
+							const double slope = (s * cell_size - secondary) / far_distance;
+
+							if (s >= first && s <= last && slope >= interval.low_ && slope <= interval.high_)
+							{
+								visit(columns ? line : s, columns ? s : line);
+							}
+						};
+
+						const auto touches = [&](int s)
+						{
+							candidate(s);
+							candidate(s + 1);
+						};
+
+						for_each_wall(cell, first - 1, last, touches);
+
+						if (cell + direction >= 0 && cell + direction < primary_cells)
+						{
+							for_each_wall(cell + direction, first - 1, last, touches);
+						}
+						else
+						{
+							candidate(0);
+							candidate(secondary_cells);
+						}
+					}
+
+					near_distance = far_distance;
+					cell += direction;
+				}
+			}
+		}
+	} // namespace
+
+	void CastFan(const GridView& grid, const Vector2d<float>& origin, float angle, float spread, int ray_count, float max_distance, VisibilityPolygon& polygon, Kernel kernel)
+	{
+		polygon.origin_ = origin;
+		polygon.closed_ = spread >= two_pi;
+		polygon.angles_.resize(static_cast<std::size_t>(std::max(ray_count, 0)));
+		polygon.points_.resize(polygon.angles_.size());
+
+		MakeFanAngles(angle, spread, polygon.closed_, polygon.angles_);
+		CastAngles(grid, MakeOriginSetup(grid, origin), polygon.angles_, max_distance, kernel, polygon.points_);
+	}
+
+	VisibilityView CastFan(Arena& arena, const GridView& grid, const Vector2d<float>& origin, float angle, float spread, int ray_count, float max_distance, Kernel kernel)
+	{
+		const std::size_t count = static_cast<std::size_t>(std::max(ray_count, 0));
+		const Span<float> angles = arena.Allocate<float>(count);
+		const Span<Vector2d<float>> points = arena.Allocate<Vector2d<float>>(count);
+		const bool closed = spread >= two_pi;
+
+		MakeFanAngles(angle, spread, closed, angles);
+		CastAngles(grid, MakeOriginSetup(grid, origin), angles, max_distance, kernel, points);
+		return { origin, angles, points, closed };
+	}
+
+	void CastCorners(const GridView& grid, const Vector2d<float>& origin, float angle, float spread, float max_distance, VisibilityPolygon& polygon, int min_ray_count, Kernel kernel)
+	{
+		std::vector<float>& angles = polygon.angles_;
+
+		polygon.origin_ = origin;
+		polygon.closed_ = spread >= two_pi;
+		angles.clear();
+
+		const float start = polygon.closed_ ? angle - two_pi / 2.0f : angle - spread / 2.0f;
+		const float range = polygon.closed_ ? two_pi : spread;
+
+		// Angles are kept relative to start while collecting, so that
+		// sorting orders them along the arc.
+		const auto add = [&](float relative)
+		{
+			relative = std::fmod(relative, two_pi);
+
+			if (relative < 0.0f)
+			{
+				relative += two_pi;
+			}
+
+			if (polygon.closed_ || relative <= range)
+			{
+				angles.push_back(relative);
+			}
+		};
+
+		const float cell_size = static_cast<float>(grid.cell_size_);
+		const float grid_width = static_cast<float>(grid.width_) * cell_size;
+		const float grid_height = static_cast<float>(grid.height_) * cell_size;
+
+		// From an origin outside the grid, corners can be further away than its diagonal.
+		const float farthest = std::hypot(std::max(std::fabs(origin.x), std::fabs(origin.x - grid_width)), std::max(std::fabs(origin.y), std::fabs(origin.y - grid_height)));
+
+		const Vector2d<int> origin_cell = { static_cast<int>(std::floor(origin.x / cell_size)), static_cast<int>(std::floor(origin.y / cell_size)) };
+
+		const auto add_corner = [&](int x, int y)
+		{
+			const Vector2d<float> offset = { static_cast<float>(x) * cell_size - origin.x, static_cast<float>(y) * cell_size - origin.y };
+
+			if (offset.GetLength() > max_distance || !IsCorner(grid, x, y, origin_cell))
+			{
+				return;
+			}
+
+			const float corner = std::atan2(offset.y, offset.x) - start;
+			add(corner - corner_epsilon);
+			add(corner + corner_epsilon);
+		};
+
+		const float reach = std::min(max_distance, farthest);
+
+		if (grid.Contains(origin_cell.x, origin_cell.y))
+		{
+			ForEachVisibleVertex(grid, origin, reach, add_corner);
+		}
+		else
+		{
+			// Bar the grid's own corners, every corner touches a wall, so
+			// only the walls within reach are visited. Each corner is taken
+			// from the first of its cells, in row order, that is a wall.
+			const auto first_cell = [cell_size](float position, int cells)
+			{
+				return static_cast<int>(std::clamp(std::floor(position / cell_size) - 1.0f, 0.0f, static_cast<float>(cells)));
+			};
+			const auto last_cell = [cell_size](float position, int cells)
+			{
+				return static_cast<int>(std::clamp(std::ceil(position / cell_size) + 1.0f, 0.0f, static_cast<float>(cells)));
+			};
+
+			ForEachWall(grid, first_cell(origin.x - reach, grid.width_), first_cell(origin.y - reach, grid.height_), last_cell(origin.x + reach, grid.width_), last_cell(origin.y + reach, grid.height_), [&](int x, int y)
+			{
+				add_corner(x + 1, y + 1);
+
+				if (!grid.IsWall(x - 1, y))
+				{
+					add_corner(x, y + 1);
+				}
+
+				if (!grid.IsWall(x, y - 1) && !grid.IsWall(x + 1, y - 1))
+				{
+					add_corner(x + 1, y);
+				}
+
+				if (!grid.IsWall(x - 1, y - 1) && !grid.IsWall(x, y - 1) && !grid.IsWall(x - 1, y))
+				{
+					add_corner(x, y);
+				}
+			});
+
+			add_corner(0, 0);
+			add_corner(grid.width_, 0);
+			add_corner(0, grid.height_);
+			add_corner(grid.width_, grid.height_);
+		}
+
+		if (min_ray_count > 0 && max_distance < farthest)
+		{
+			for (int i = 0; i <= min_ray_count; ++i)
+			{
+				add(range * static_cast<float>(i) / static_cast<float>(min_ray_count));
+			}
+		}
+
+		if (!polygon.closed_)
+		{
+			angles.push_back(0.0f);
+			angles.push_back(range);
+		}
+
+		std::sort(angles.begin(), angles.end());
+		angles.erase(std::unique(angles.begin(), angles.end()), angles.end());
+
+		for (float& relative : angles)
+		{
+			relative += start;
+		}
+
+		polygon.points_.resize(angles.size());
+		CastAngles(grid, MakeOriginSetup(grid, origin), angles, max_distance, kernel, polygon.points_);
+	}
+} // namespace dda
\ No newline at end of file
@@ -1,13 +1,72 @@
 #include "Game.hpp"
 
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 
 int main(int argc, char* argv[])
 {
-	(void) argc;
-	(void) argv;
+	const char* replay_path = nullptr;
+
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--replay") == 0)
+		{
+			replay_path = argv[i + 1];
+		}
+	}
+
+	const std::unique_ptr<Game> game = std::make_unique<Game>(replay_path != nullptr);
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			++i;
+		}
+		else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+		{
+			game->OpenProfileDump(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--map") == 0 && i + 1 < argc)
+		{
+			game->LoadMap(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--pipelined") == 0)
+		{
+			game->SetPipelined(true);
+		}
+		else if (std::strcmp(argv[i], "--vsync") == 0)
+		{
+			game->SetFramePacing(PacingMode::vsync, 60);
+		}
+		else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+		{
+			game->SetFramePacing(PacingMode::capped, std::atoi(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--uncapped") == 0)
+		{
+			game->SetFramePacing(PacingMode::uncapped, 60);
+		}
+		else if (std::strcmp(argv[i], "--agents") == 0 && i + 1 < argc)
+		{
+			game->SetAgentCount(static_cast<std::size_t>(std::atoi(argv[++i])));
+		}
+		else if (std::strcmp(argv[i], "--gpu") == 0)
+		{
+			game->SetUseGpu(true);
+		}
+		else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			game->SetRecordPath(argv[++i]);
+		}
+	}
+
+	if (replay_path != nullptr)
+	{
+		return game->Replay(replay_path) ? 0 : 1;
+	}
 
-	const std::unique_ptr<Game> game = std::make_unique<Game>();
 	game->Run();
 
 	return 0;
@@ -0,0 +1,104 @@
+#include "dda/Grid.hpp"
+#include "dda/JobPool.hpp"
+#include "dda/Kernel.hpp"
+#include "dda/Protocol.hpp"
+#include "dda/RayService.hpp"
+#include "Vector2d.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	template <typename T>
+	void Append(std::vector<std::uint8_t>& bytes, const T& value)
+	{
+		const std::size_t offset = bytes.size();
+		bytes.resize(offset + sizeof(T));
+		std::memcpy(bytes.data() + offset, &value, sizeof(T));
+	}
+
+	/* A cast of count rays from the middle of cell (1, 1) along +x, as one frame. */
+	std::vector<std::uint8_t> MakeCast(std::uint32_t id, std::uint32_t count)
+	{
+		std::vector<std::uint8_t> frame;
+		frame.reserve(sizeof(dda::FrameHeader) + sizeof(dda::CastRequest) + std::size_t{ count } * 2 * sizeof(Vector2d<float>));
+
+		Append(frame, dda::FrameHeader{ static_cast<std::uint32_t>(sizeof(dda::CastRequest) + std::size_t{ count } * 2 * sizeof(Vector2d<float>)), static_cast<std::uint16_t>(dda::FrameType::cast), 0, id, count });
+		Append(frame, dda::CastRequest{ 1000.0f, static_cast<std::uint8_t>(dda::Kernel::scalar), {} });
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			Append(frame, Vector2d<float>{ 48.0f, 48.0f });
+		}
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			Append(frame, Vector2d<float>{ 1.0f, 0.0f });
+		}
+
+		return frame;
+	}
+
+	/* Serves frame whole and reads back the header of its one response. */
+	bool Serve(dda::RayService& service, const std::vector<std::uint8_t>& frame, dda::FrameHeader& header, std::vector<std::uint8_t>& output)
+	{
+		std::size_t consumed = 0;
+		output.clear();
+
+		if (!service.Serve(frame, consumed, output) || consumed != frame.size() || output.size() < sizeof(dda::FrameHeader))
+		{
+			return false;
+		}
+
+		std::memcpy(&header, output.data(), sizeof(dda::FrameHeader));
+		return output.size() == sizeof(dda::FrameHeader) + header.size_;
+	}
+
+	bool Check(bool passed, const char* name)
+	{
+		printf("%s %s\n", passed ? "PASS" : "FAIL", name);
+		return passed;
+	}
+} // namespace
+
+int main()
+{
+	dda::JobPool pool(2);
+	dda::RayService service(pool);
+	dda::Grid walls(64, 64, 32);
+	walls.SetWall(10, 1, true);
+	service.SetWalls(walls.GetView());
+
+	bool passed = true;
+	dda::FrameHeader header;
+	std::vector<std::uint8_t> output;
+
+	// The most rays a request can carry; their hits would not fit in a frame.
+	const std::uint32_t largest_request = static_cast<std::uint32_t>((dda::max_frame_body - sizeof(dda::CastRequest)) / (2 * sizeof(Vector2d<float>)));
+	const bool oversized = Serve(service, MakeCast(7, largest_request), header, output);
+	dda::ErrorResult error = { 0 };
+
+	if (oversized && header.size_ == sizeof(dda::ErrorResult))
+	{
+		std::memcpy(&error, output.data() + sizeof(dda::FrameHeader), sizeof(dda::ErrorResult));
+	}
+
+	passed &= Check(oversized && header.type_ == static_cast<std::uint16_t>(dda::FrameType::error) && header.id_ == 7 && error.error_ == static_cast<std::uint32_t>(dda::ServiceError::response_too_large), "oversized cast is refused with response_too_large");
+
+	// The most rays whose hits still fit are answered in full.
+	const std::uint32_t largest_answer = static_cast<std::uint32_t>(dda::max_frame_body / sizeof(dda::HitResult));
+	const bool largest = Serve(service, MakeCast(8, largest_answer), header, output);
+	dda::HitResult hit = {};
+
+	if (largest && header.size_ >= sizeof(dda::HitResult))
+	{
+		std::memcpy(&hit, output.data() + output.size() - sizeof(dda::HitResult), sizeof(dda::HitResult));
+	}
+
+	passed &= Check(largest && header.type_ == static_cast<std::uint16_t>(dda::FrameType::cast_result) && header.count_ == largest_answer && header.size_ <= dda::max_frame_body && hit.hit_ == 1 && hit.cell_x_ == 10, "largest cast that fits is answered");
+
+	return passed ? 0 : 1;
+}
\ No newline at end of file